@@ -0,0 +1,121 @@
+#!/bin/bash
+# Checks that the bulk path (-B, LOAD DATA LOCAL INFILE) imports the same data as the INSERT path.
+# It generates submissions with big repeats (use the loops and the repeats with OSM data in -r),
+# imports them into two throwaway schemas, one with -B and one without, and compares the rows
+# of each table and the record maps (the UUIDs are random so they are not compared).
+# The server must allow LOCAL INFILE (local_infile=ON). Exits with 1 if anything differs.
+#
+# Usage: ./check-bulk.sh -c create.xml -i insert.xml -m manifest.xml -u user -p pass -r "repeat1,repeat2"
+#          [-H host] [-P port] [-s schema] [-S items per repeat] [-n files] [-T bulk threshold]
+#          [-x extra jsontomysql arguments, e.g. OSM support files] [-B bin dir]
+
+HOST=localhost
+PORT=3306
+SCHEMA=odktools_bulkcheck
+ITEMS=2000
+FILES=3
+THRESHOLD=500
+BIN=.
+EXTRA=""
+REPEATS=""
+DBUSER=""
+PASS=""
+
+while getopts "c:i:m:u:p:H:P:s:r:S:n:T:x:B:" opt; do
+    case $opt in
+        c) CREATE=$OPTARG ;;
+        i) INSERT=$OPTARG ;;
+        m) MANIFEST=$OPTARG ;;
+        u) DBUSER=$OPTARG ;;
+        p) PASS=$OPTARG ;;
+        H) HOST=$OPTARG ;;
+        P) PORT=$OPTARG ;;
+        s) SCHEMA=$OPTARG ;;
+        r) REPEATS=$OPTARG ;;
+        S) ITEMS=$OPTARG ;;
+        n) FILES=$OPTARG ;;
+        T) THRESHOLD=$OPTARG ;;
+        x) EXTRA=$OPTARG ;;
+        B) BIN=$OPTARG ;;
+        *) exit 1 ;;
+    esac
+done
+
+if [ -z "$CREATE" ] || [ -z "$INSERT" ] || [ -z "$MANIFEST" ] || [ -z "$DBUSER" ] || [ -z "$REPEATS" ]; then
+    echo "The create XML (-c), insert XML (-i), manifest (-m), MySQL user (-u) and repeats (-r) are required"
+    exit 1
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+# The credentials go in an option file so the password is not expanded by the shell or seen in ps
+# Backslashes and double quotes are escaped inside the quoted value
+ESCAPED=${PASS//\\/\\\\}
+ESCAPED=${ESCAPED//\"/\\\"}
+cat > "$WORK/my.cnf" <<EOF
+[client]
+host=$HOST
+port=$PORT
+user=$DBUSER
+password="$ESCAPED"
+EOF
+chmod 600 "$WORK/my.cnf"
+MYSQL=(mysql --defaults-extra-file="$WORK/my.cnf" --local-infile=1)
+
+"$BIN/createfromxml" -i "$CREATE" -o "$WORK/create.sql" > /dev/null || exit 1
+"$BIN/insertfromxml" -i "$INSERT" -o "$WORK/insert.sql" > /dev/null || exit 1
+
+ARRAYS=""
+for REPEAT in ${REPEATS//,/ }; do
+    ARRAYS="$ARRAYS$REPEAT:$ITEMS,"
+done
+mkdir -p "$WORK/corpus"
+for ((SEED = 1; SEED <= FILES; SEED++)); do
+    "$BIN/createdummyjson" -c "$CREATE" -i "$INSERT" -v -k $SEED -a "$ARRAYS" -o "$WORK/corpus/$SEED.json" > /dev/null || exit 1
+done
+
+# Imports the corpus into a new schema. $1 is the name of the run and the rest are extra arguments
+import() {
+    local RUN=$1
+    shift
+    "${MYSQL[@]}" -e "DROP DATABASE IF EXISTS ${SCHEMA}_$RUN; CREATE DATABASE ${SCHEMA}_$RUN CHARACTER SET utf8mb4;" || exit 1
+    "${MYSQL[@]}" "${SCHEMA}_$RUN" < "$WORK/create.sql" || exit 1
+    "${MYSQL[@]}" "${SCHEMA}_$RUN" < "$WORK/insert.sql" || exit 1
+    "$BIN/jsontomysql" -H "$HOST" -P "$PORT" -u "$DBUSER" -p "$PASS" -s "${SCHEMA}_$RUN" -m "$MANIFEST" -d "$WORK/corpus" \
+        -e "$WORK/errors_$RUN" -M "$WORK/maps_$RUN" -U "$WORK/uuids_$RUN.log" -o "$WORK/output_$RUN.xml" \
+        $EXTRA "$@" > "$WORK/log_$RUN.txt"
+    if [ $? -ne 0 ]; then
+        echo "The import of the $RUN run failed"
+        cat "$WORK/log_$RUN.txt"
+        exit 1
+    fi
+    "${MYSQL[@]}" -N -B -e "SELECT TABLE_NAME FROM information_schema.TABLES WHERE TABLE_SCHEMA = '${SCHEMA}_$RUN' ORDER BY TABLE_NAME" > "$WORK/tables_$RUN.txt" || exit 1
+    : > "$WORK/rows_$RUN.txt"
+    while read -r TABLE; do
+        echo "$TABLE $("${MYSQL[@]}" -N -B -e "SELECT COUNT(*) FROM \`$TABLE\`" "${SCHEMA}_$RUN")" >> "$WORK/rows_$RUN.txt"
+    done < "$WORK/tables_$RUN.txt"
+    mkdir -p "$WORK/normalized_$RUN"
+    for MAP in "$WORK/maps_$RUN"/*; do
+        [ -f "$MAP" ] || continue
+        sed 's/uuid="[^"]*"/uuid=""/g' "$MAP" > "$WORK/normalized_$RUN/$(basename "$MAP")"
+    done
+}
+
+import insert
+import bulk -B "$THRESHOLD"
+
+STATUS=0
+if ! diff "$WORK/rows_insert.txt" "$WORK/rows_bulk.txt"; then
+    echo "The number of rows differs between the INSERT and the bulk imports"
+    STATUS=1
+fi
+if ! diff -r "$WORK/normalized_insert" "$WORK/normalized_bulk" > /dev/null; then
+    echo "The record maps differ between the INSERT and the bulk imports"
+    STATUS=1
+fi
+if [ $STATUS -eq 0 ]; then
+    echo "OK: $(awk '{s+=$2} END {print s}' "$WORK/rows_bulk.txt") rows in $(wc -l < "$WORK/rows_bulk.txt") tables match"
+fi
+
+"${MYSQL[@]}" -e "DROP DATABASE IF EXISTS ${SCHEMA}_insert; DROP DATABASE IF EXISTS ${SCHEMA}_bulk;"
+exit $STATUS
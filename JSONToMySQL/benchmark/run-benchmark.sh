@@ -0,0 +1,109 @@
+#!/bin/bash
+# Measures the import throughput of jsontomysql with synthetic submissions.
+# For each scale it generates a corpus with createdummyjson, creates a throwaway
+# schema with createfromxml and insertfromxml, imports the corpus and reports
+# rows per second, the time of each phase and the peak memory (needs jq).
+#
+# Usage: ./run-benchmark.sh -c create.xml -i insert.xml -m manifest.xml -u user -p pass
+#          [-H host] [-P port] [-s schema] [-r "repeat1,repeat2"] [-S "1,10,100"]
+#          [-n files] [-t threads] [-b batchsize] [-x extra jsontomysql arguments] [-B bin dir]
+#          [-o output directory for the statistics (./benchmark_stats by default)]
+
+HOST=localhost
+PORT=3306
+SCHEMA=odktools_benchmark
+SCALES="1,10,100"
+FILES=100
+THREADS=1
+BATCH=500
+BIN=.
+EXTRA=""
+REPEATS=""
+DBUSER=""
+PASS=""
+OUTPUT=./benchmark_stats
+
+while getopts "c:i:m:u:p:H:P:s:r:S:n:t:b:x:B:o:" opt; do
+    case $opt in
+        c) CREATE=$OPTARG ;;
+        i) INSERT=$OPTARG ;;
+        m) MANIFEST=$OPTARG ;;
+        u) DBUSER=$OPTARG ;;
+        p) PASS=$OPTARG ;;
+        H) HOST=$OPTARG ;;
+        P) PORT=$OPTARG ;;
+        s) SCHEMA=$OPTARG ;;
+        r) REPEATS=$OPTARG ;;
+        S) SCALES=$OPTARG ;;
+        n) FILES=$OPTARG ;;
+        t) THREADS=$OPTARG ;;
+        b) BATCH=$OPTARG ;;
+        x) EXTRA=$OPTARG ;;
+        B) BIN=$OPTARG ;;
+        o) OUTPUT=$OPTARG ;;
+        *) exit 1 ;;
+    esac
+done
+
+if [ -z "$CREATE" ] || [ -z "$INSERT" ] || [ -z "$MANIFEST" ] || [ -z "$DBUSER" ]; then
+    echo "The create XML (-c), insert XML (-i), manifest (-m) and MySQL user (-u) are required"
+    exit 1
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+mkdir -p "$OUTPUT" || exit 1
+# The credentials go in an option file so the password is not expanded by the shell, an empty
+# password does not make mysql prompt for one and it is not seen in ps
+# Backslashes and double quotes are escaped inside the quoted value
+ESCAPED=${PASS//\\/\\\\}
+ESCAPED=${ESCAPED//\"/\\\"}
+cat > "$WORK/my.cnf" <<EOF
+[client]
+host=$HOST
+port=$PORT
+user=$DBUSER
+password="$ESCAPED"
+EOF
+chmod 600 "$WORK/my.cnf"
+MYSQL=(mysql --defaults-extra-file="$WORK/my.cnf")
+
+"$BIN/createfromxml" -i "$CREATE" -o "$WORK/create.sql" > /dev/null || exit 1
+"$BIN/insertfromxml" -i "$INSERT" -o "$WORK/insert.sql" > /dev/null || exit 1
+
+printf "%-8s %-8s %-12s %-12s %-12s %-10s\n" "Scale" "Files" "Rows" "Time(ms)" "Rows/s" "PeakRSS(KB)"
+for SCALE in ${SCALES//,/ }; do
+    # The corpus: every repeat gets SCALE items and each file has its own key
+    ARRAYS=""
+    for REPEAT in ${REPEATS//,/ }; do
+        ARRAYS="$ARRAYS$REPEAT:$SCALE,"
+    done
+    CORPUS="$WORK/corpus_$SCALE"
+    mkdir -p "$CORPUS"
+    for ((SEED = 1; SEED <= FILES; SEED++)); do
+        "$BIN/createdummyjson" -c "$CREATE" -i "$INSERT" -v -k $SEED -a "$ARRAYS" -o "$CORPUS/$SEED.json" > /dev/null || exit 1
+    done
+
+    # A new schema for each scale so all the runs start from the same state
+    "${MYSQL[@]}" -e "DROP DATABASE IF EXISTS $SCHEMA; CREATE DATABASE $SCHEMA CHARACTER SET utf8mb4;" || exit 1
+    "${MYSQL[@]}" "$SCHEMA" < "$WORK/create.sql" || exit 1
+    "${MYSQL[@]}" "$SCHEMA" < "$WORK/insert.sql" || exit 1
+
+    # A new statistics file for each run so the stats of a previous run are not read by mistake
+    STATS="$OUTPUT/stats_$SCALE.json"
+    rm -f "$STATS"
+    "$BIN/jsontomysql" -H "$HOST" -P "$PORT" -u "$DBUSER" -p "$PASS" -s "$SCHEMA" -m "$MANIFEST" -d "$CORPUS" \
+        -e "$WORK/errors_$SCALE" -M "$WORK/maps_$SCALE" -U "$WORK/uuids_$SCALE.log" -o "$WORK/output_$SCALE.xml" \
+        -t $THREADS -b $BATCH -T "$STATS" $EXTRA > "$WORK/log_$SCALE.txt"
+    if [ ! -f "$STATS" ]; then
+        cat "$WORK/log_$SCALE.txt"
+        exit 1
+    fi
+    printf "%-8s %-8s %-12s %-12s %-12.1f %-10s\n" $SCALE \
+        "$(jq '.filesImported' "$STATS")/$FILES" \
+        "$(jq '.rowsInserted' "$STATS")" \
+        "$(jq '.wallTime' "$STATS")" \
+        "$(jq '.rowsPerSecond // 0' "$STATS")" \
+        "$(jq '.peakRSS // 0' "$STATS")"
+    jq -r '.phases | to_entries[] | "         \(.key): \(.value.time) ms in \(.value.calls) calls"' "$STATS"
+done
@@ -0,0 +1,98 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#include "checkpointfile.h"
+#include <QTextStream>
+
+checkpointFile::checkpointFile()
+{
+
+}
+
+//Reads the chunks committed by a previous run and opens the file to add new ones
+bool checkpointFile::open(QString jsonFile)
+{
+    chunks.clear();
+    file.setFileName(jsonFile + ".checkpoint");
+    if (file.exists())
+    {
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            return false;
+        QTextStream in(&file);
+        while (!in.atEnd())
+        {
+            QStringList parts = in.readLine().split("\t");
+            if (parts.count() != 3)
+                continue;
+            bool ok;
+            int chunk = parts[0].toInt(&ok);
+            if (!ok)
+                continue;
+            QStringList UUIDs;
+            if (parts[2] != "")
+                UUIDs = parts[2].split(",");
+            if (UUIDs.count() != parts[1].toInt())
+                continue;
+            chunks.insert(chunk, UUIDs);
+        }
+        file.close();
+    }
+    return file.open(QIODevice::Append | QIODevice::Text);
+}
+
+bool checkpointFile::isCommitted(int chunk) const
+{
+    return chunks.contains(chunk);
+}
+
+QStringList checkpointFile::UUIDs(int chunk) const
+{
+    return chunks.value(chunk);
+}
+
+int checkpointFile::committedChunks() const
+{
+    return chunks.count();
+}
+
+//Records a chunk once its transaction is committed
+bool checkpointFile::commitChunk(int chunk, const QStringList &UUIDs)
+{
+    chunks.insert(chunk, UUIDs);
+    QByteArray line;
+    line = QString(QString::number(chunk) + "\t" + QString::number(UUIDs.count()) + "\t" + UUIDs.join(",") + "\n").toUtf8();
+    if (file.write(line) != line.size())
+        return false;
+    return file.flush();
+}
+
+void checkpointFile::close()
+{
+    if (file.isOpen())
+        file.close();
+}
+
+//The submission is complete so the sidecar is no longer needed
+void checkpointFile::remove()
+{
+    close();
+    file.remove();
+    chunks.clear();
+}
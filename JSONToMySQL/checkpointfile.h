@@ -0,0 +1,49 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#ifndef CHECKPOINTFILE_H
+#define CHECKPOINTFILE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QFile>
+
+//The sidecar file of a submission imported in checkpoint mode. It has one line
+//for each committed chunk with the UUIDs given to its rows in creation order:
+//chunk<TAB>number of UUIDs<TAB>uuid,uuid,...
+//A line that was not completely written is ignored.
+class checkpointFile
+{
+public:
+    checkpointFile();
+    bool open(QString jsonFile);
+    bool isCommitted(int chunk) const;
+    QStringList UUIDs(int chunk) const;
+    int committedChunks() const;
+    bool commitChunk(int chunk, const QStringList &UUIDs);
+    void close();
+    void remove();
+private:
+    QFile file;
+    QHash<int, QStringList> chunks;
+};
+
+#endif // CHECKPOINTFILE_H
@@ -0,0 +1,78 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#include "filequeue.h"
+
+fileQueue::fileQueue()
+{
+    closed = false;
+}
+
+void fileQueue::add(QString file)
+{
+    mutex.lock();
+    files.append(file);
+    filesAvailable.wakeOne();
+    mutex.unlock();
+}
+
+void fileQueue::add(QStringList files)
+{
+    mutex.lock();
+    this->files.append(files);
+    filesAvailable.wakeAll();
+    mutex.unlock();
+}
+
+//Takes the next file from the queue. It waits for new files until the queue is closed.
+//Returns false when the queue is closed and has no more files
+bool fileQueue::take(QString &file)
+{
+    bool res = false;
+    mutex.lock();
+    while (files.isEmpty() && !closed)
+        filesAvailable.wait(&mutex);
+    if (!files.isEmpty())
+    {
+        file = files.takeFirst();
+        res = true;
+    }
+    mutex.unlock();
+    return res;
+}
+
+//No more files will be added. The workers finish once the queue is empty
+void fileQueue::close()
+{
+    mutex.lock();
+    closed = true;
+    filesAvailable.wakeAll();
+    mutex.unlock();
+}
+
+//Removes the pending files and closes the queue. Used when a worker finds a fatal error
+void fileQueue::abort()
+{
+    mutex.lock();
+    files.clear();
+    closed = true;
+    filesAvailable.wakeAll();
+    mutex.unlock();
+}
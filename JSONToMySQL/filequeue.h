@@ -0,0 +1,45 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#ifndef FILEQUEUE_H
+#define FILEQUEUE_H
+
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+
+//A thread safe queue of JSON files shared by the import workers
+class fileQueue
+{
+public:
+    fileQueue();
+    void add(QString file);
+    void add(QStringList files);
+    bool take(QString &file);
+    void close();
+    void abort();
+private:
+    QStringList files;
+    bool closed;
+    QMutex mutex;
+    QWaitCondition filesAvailable;
+};
+
+#endif // FILEQUEUE_H
@@ -0,0 +1,305 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#include "importoutput.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDataStream>
+
+importOutput::importOutput()
+{
+    imported = 0;
+    withErrors = 0;
+    validateOnly = false;
+}
+
+//The files are only validated so there are no UUIDs or maps to write
+void importOutput::setValidateOnly()
+{
+    validateOnly = true;
+}
+
+//In spool mode each JSON file is moved to the done or error directory once its outputs are written
+void importOutput::setSpool(QString doneDir, QString errorDir)
+{
+    spoolDoneDir = doneDir;
+    spoolErrorDir = errorDir;
+}
+
+//Moves a file of the spool to a directory replacing any file with the same name
+void importOutput::moveFile(QString fileName, QString directory)
+{
+    QFileInfo fi(fileName);
+    QString target = directory + QDir::separator() + fi.fileName();
+    if (QFile::exists(target))
+        QFile::remove(target);
+    if (!QFile::rename(fileName, target))
+        log("Error: Cannot move " + fileName + " to " + directory);
+    //The checkpoint of a file imported in parts goes with it
+    if (QFile::exists(fileName + ".checkpoint"))
+    {
+        if (QFile::exists(target + ".checkpoint"))
+            QFile::remove(target + ".checkpoint");
+        QFile::rename(fileName + ".checkpoint", target + ".checkpoint");
+    }
+    if (QFile::exists(fileName + ".committed"))
+        QFile::remove(fileName + ".committed");
+}
+
+//In spool mode saves the outputs of a committed file in a .committed file next to it. If the process
+//stops before the file is moved to done the next run writes these outputs instead of importing it again
+void importOutput::markCommitted(const TfileResult &result)
+{
+    if (spoolDoneDir == "")
+        return;
+    QString marker = result.fileName + ".committed";
+    QFile file(marker + ".tmp");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        log("Error: Cannot create " + marker);
+        return;
+    }
+    QDataStream out(&file);
+    out << result.fileID << result.UUIDs << result.recordMap;
+    file.close();
+    if (QFile::exists(marker))
+        QFile::remove(marker);
+    if (!QFile::rename(marker + ".tmp", marker))
+        log("Error: Cannot create " + marker);
+}
+
+bool importOutput::isCommitted(QString fileName)
+{
+    return QFile::exists(fileName + ".committed");
+}
+
+//Writes the outputs saved by markCommitted and moves the file to done
+int importOutput::writeCommitted(QString fileName)
+{
+    QFile file(fileName + ".committed");
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        log("Error: Cannot read " + fileName + ".committed");
+        return 1;
+    }
+    TfileResult result;
+    result.fileName = fileName;
+    result.status = 0;
+    QDataStream in(&file);
+    in >> result.fileID >> result.UUIDs >> result.recordMap;
+    file.close();
+    if (in.status() != QDataStream::Ok)
+    {
+        log("Error: Cannot read " + fileName + ".committed");
+        return 1;
+    }
+    QMutexLocker locker(&mutex);
+    return writeResult(result);
+}
+
+void importOutput::log(QString message)
+{
+    QString temp;
+    temp = message + "\n";
+    printf("%s",temp.toLocal8Bit().data());
+}
+
+//Opens the UUIDs file and the logs. Returns 0 if all the outputs are ready
+int importOutput::open(bool overwrite, QString output, QString outputType, QString UUIDsFile, QString mapOutputDir, bool batchMode, QString errorOutputDir)
+{
+    this->output = output;
+    this->outputType = outputType;
+    this->mapOutputDir = mapOutputDir;
+    this->batchMode = batchMode;
+    this->errorOutputDir = errorOutputDir;
+
+    if (!validateOnly)
+    {
+        UUIDFile.setFileName(UUIDsFile);
+        //The file is new so write from start. A spool keeps the UUIDs of previous runs
+        QIODevice::OpenMode UUIDMode = QIODevice::WriteOnly | QIODevice::Text;
+        if (spoolDoneDir != "")
+            UUIDMode = UUIDMode | QIODevice::Append;
+        if (!UUIDFile.open(UUIDMode))
+        {
+            log("Cannot create processing file");
+            return 1;
+        }
+        UUIDout.setDevice(&UUIDFile); //Stream to the processing file
+
+        QDir mapDir(mapOutputDir);
+        if (!mapDir.exists())
+        {
+            if (!mapDir.mkpath(mapOutputDir))
+            {
+                log("Output map directory does not exist and cannot be created");
+                return 1;
+            }
+        }
+    }
+
+    //In batch mode each file with errors gets its own machine readable log
+    if ((batchMode) && (outputType != "h"))
+    {
+        QDir errorDir(errorOutputDir);
+        if (!errorDir.exists())
+        {
+            if (!errorDir.mkpath(errorOutputDir))
+            {
+                log("Error log directory does not exist and cannot be created");
+                return 1;
+            }
+        }
+    }
+
+    //Loggin file
+    if (outputType == "h")
+    {
+        logFile.setFileName(output);
+        if (!QFile::exists(output) || overwrite)
+        {
+            if (!logFile.open(QIODevice::WriteOnly | QIODevice::Text))
+            {
+                log("Cannot create log file");
+                return 1;
+            }
+            logStream.setDevice(&logFile);
+            logStream << "FileUUID\tTable\tRowInJSON\tJSONVariable\tError\tNotes\tSQLExecuted\n";
+        }
+        else
+        {
+            if (!logFile.open(QIODevice::Append | QIODevice::Text))
+            {
+                log("Cannot create log file");
+                return 1;
+            }
+            logStream.setDevice(&logFile);
+        }
+    }
+    return 0;
+}
+
+//Writes the outputs of an imported file. Returns 1 if an output cannot be written
+int importOutput::write(const TfileResult &result)
+{
+    QMutexLocker locker(&mutex);
+    return writeResult(result);
+}
+
+int importOutput::writeResult(const TfileResult &result)
+{
+    if (outputType == "h")
+    {
+        if (result.humanLog != "")
+        {
+            logStream << result.humanLog;
+            logStream.flush();
+        }
+    }
+    else
+    {
+        if (!result.xmlLog.isEmpty())
+        {
+            QString XMLLogFileName;
+            if (batchMode)
+                XMLLogFileName = errorOutputDir + QDir::separator() + result.fileID + ".xml";
+            else
+                XMLLogFileName = output;
+            QFile XMLLogFile(XMLLogFileName);
+            if (XMLLogFile.open(QIODevice::WriteOnly | QIODevice::Text))
+            {
+                XMLLogFile.write(result.xmlLog);
+                XMLLogFile.close();
+            }
+            else
+            {
+                log("Error: Cannot create error log file " + XMLLogFileName);
+                return 1;
+            }
+        }
+    }
+    if (result.status != 0)
+    {
+        withErrors++;
+        if (batchMode)
+        {
+            if (validateOnly)
+                log("Error: File " + result.fileName + " is not valid");
+            else
+                log("Error: File " + result.fileName + " was not imported");
+        }
+        if (spoolErrorDir != "")
+            moveFile(result.fileName, spoolErrorDir);
+        return 0;
+    }
+
+    imported++;
+    if (validateOnly)
+        return 0;
+    for (int aUUID = 0; aUUID <= result.UUIDs.count()-1; aUUID++)
+    {
+        UUIDout << result.UUIDs.at(aUUID) + "\n";
+    }
+    UUIDout.flush();
+
+    //We store the map file
+    QDir mapDir(mapOutputDir);
+    QString mapFile;
+    mapFile = mapDir.path() + mapDir.separator() + result.fileID + ".xml";
+    QFile file(mapFile);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        file.write(result.recordMap);
+        file.close();
+    }
+    else
+        log("Error: Cannot create xml manifest file");
+    if (spoolDoneDir != "")
+        moveFile(result.fileName, spoolDoneDir);
+    return 0;
+}
+
+void importOutput::close()
+{
+    QMutexLocker locker(&mutex);
+    if (UUIDFile.isOpen())
+        UUIDFile.close();
+    if (outputType == "h")
+    {
+        logFile.close();
+        QFileInfo fiLog(output);
+        if (fiLog.size() == 62)
+        {
+            logFile.remove();
+        }
+    }
+}
+
+int importOutput::filesImported()
+{
+    QMutexLocker locker(&mutex);
+    return imported;
+}
+
+int importOutput::filesWithErrors()
+{
+    QMutexLocker locker(&mutex);
+    return withErrors;
+}
@@ -0,0 +1,81 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#ifndef IMPORTOUTPUT_H
+#define IMPORTOUTPUT_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QFile>
+#include <QTextStream>
+#include <QMutex>
+
+//The outcome of importing one JSON file
+struct fileResult
+{
+    QString fileName;
+    QString fileID;
+    int status; //0 = Imported, 2 = Rolled back
+    QStringList UUIDs; //table,uuid of each row inserted
+    QString humanLog; //Error lines for the human readable log
+    QByteArray xmlLog; //Machine readable error log. Empty if there are no errors
+    QByteArray recordMap; //Record map of the file
+};
+typedef fileResult TfileResult;
+
+//Writes the outputs shared by all the files: UUIDs file, error logs and record maps.
+//The workers write through it so the writes are serialized.
+class importOutput
+{
+public:
+    importOutput();
+    void setSpool(QString doneDir, QString errorDir);
+    void setValidateOnly();
+    int open(bool overwrite, QString output, QString outputType, QString UUIDsFile, QString mapOutputDir, bool batchMode, QString errorOutputDir);
+    int write(const TfileResult &result);
+    void markCommitted(const TfileResult &result);
+    bool isCommitted(QString fileName);
+    int writeCommitted(QString fileName);
+    void close();
+    int filesImported();
+    int filesWithErrors();
+private:
+    void log(QString message);
+    void moveFile(QString fileName, QString directory);
+    int writeResult(const TfileResult &result);
+    QMutex mutex;
+    QString output;
+    QString outputType;
+    QString mapOutputDir;
+    bool batchMode;
+    QString errorOutputDir;
+    QString spoolDoneDir;
+    QString spoolErrorDir;
+    bool validateOnly;
+    QFile UUIDFile;
+    QTextStream UUIDout;
+    QFile logFile;
+    QTextStream logStream;
+    int imported;
+    int withErrors;
+};
+
+#endif // IMPORTOUTPUT_H
@@ -0,0 +1,152 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#include "importplan.h"
+#include <QFile>
+#include <QDomDocument>
+#include <QDomElement>
+
+importPlan::importPlan()
+{
+
+}
+
+//Parses the manifest file and compiles it into the plan. Returns 0 if the manifest was compiled
+int importPlan::load(QString manifest)
+{
+    tables.clear();
+    QDomDocument doc("mydocument");
+    QFile xmlfile(manifest);
+    if (!xmlfile.open(QIODevice::ReadOnly))
+        return 1;
+    if (!doc.setContent(&xmlfile))
+    {
+        xmlfile.close();
+        return 1;
+    }
+    xmlfile.close();
+
+    //Gets the first table of the file
+    QDomNode root;
+    root = doc.firstChild().nextSibling().firstChild();
+    if (root.isNull())
+        return 1;
+    compileTable(root);
+    return 0;
+}
+
+//Compiles a table node and its children. The root table is always the first in the list
+int importPlan::compileTable(QDomNode table)
+{
+    QDomElement eTable = table.toElement();
+    TimportTable aTable;
+    aTable.name = eTable.attribute("mysqlcode","none");
+    aTable.xmlCode = eTable.attribute("xmlcode","none");
+    aTable.isMain = (eTable.attribute("xmlcode") == "main");
+    aTable.group = (eTable.attribute("group","false") == "true");
+    aTable.osm = (eTable.attribute("osm","false") == "true");
+    aTable.loop = (eTable.attribute("loop","false") == "true");
+    aTable.hasFieldNodes = false;
+    if (aTable.loop)
+        aTable.loopItems = eTable.attribute("loopitems","").split(QChar(743),QString::SkipEmptyParts);
+
+    int index = tables.count();
+    tables.append(aTable);
+
+    QList<int> children;
+    QDomNode child = table.firstChild();
+    while (!child.isNull())
+    {
+        QDomElement eChild = child.toElement();
+        if (eChild.nodeName() == "field")
+        {
+            tables[index].hasFieldNodes = true;
+            //We not process referenced fields because they come as part of the key
+            if (eChild.attribute("reference") == "false")
+            {
+                TfieldDef field;
+                field.name = eChild.attribute("mysqlcode");
+                field.xmlCode = eChild.attribute("xmlcode");
+                field.type = eChild.attribute("type","varchar");
+                field.ODKType = eChild.attribute("odktype","text");
+                field.size = eChild.attribute("size","0").toInt();
+                field.decSize = eChild.attribute("decsize","0").toInt();
+                field.key = (eChild.attribute("key") == "true");
+                if (eChild.attribute("isMultiSelect","false") == "true")
+                {
+                    field.multiSelect = true;
+                    field.multiSelectTable = eChild.attribute("multiSelectTable","");
+                }
+                else
+                    field.multiSelect = false;
+                if (field.key)
+                    tables[index].keyPositions.append(tables[index].fields.count());
+                tables[index].fields.append(field);
+            }
+        }
+        else
+            children.append(compileTable(child));
+        if (aTable.loop)
+        {
+            if (eChild.attribute("xmlcode","NONE") != "NONE")
+            {
+                TfieldDef aLoopField;
+                aLoopField.xmlCode = eChild.attribute("xmlcode","");
+                aLoopField.decSize = eChild.attribute("decsize","0").toInt();
+                aLoopField.key = false;
+                if (eChild.attribute("isMultiSelect","false") == "true")
+                {
+                    aLoopField.multiSelect = true;
+                    aLoopField.multiSelectTable = eChild.attribute("multiSelectTable","");
+                }
+                else
+                    aLoopField.multiSelect = false;
+                aLoopField.name = eChild.attribute("mysqlcode","");
+                aLoopField.ODKType = eChild.attribute("odktype","");
+                aLoopField.size = eChild.attribute("size","0").toInt();
+                aLoopField.type = eChild.attribute("type","varchar");
+                tables[index].loopFields.append(aLoopField);
+            }
+        }
+        child = child.nextSibling();
+    }
+    tables[index].children = children;
+    return index;
+}
+
+bool importPlan::isEmpty() const
+{
+    return tables.isEmpty();
+}
+
+const TimportTable &importPlan::root() const
+{
+    return tables[0];
+}
+
+const TimportTable &importPlan::table(int index) const
+{
+    return tables[index];
+}
+
+int importPlan::count() const
+{
+    return tables.count();
+}
@@ -0,0 +1,78 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#ifndef IMPORTPLAN_H
+#define IMPORTPLAN_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QDomNode>
+
+struct fieldDef
+{
+  QString name;
+  QString xmlCode;
+  QString value;
+  bool key;
+  bool multiSelect;
+  QString multiSelectTable;
+  QString uuid;
+  QString type;
+  int size;
+  int decSize;
+  QString ODKType;
+};
+typedef fieldDef TfieldDef;
+
+// A table of the manifest compiled into a flat structure. All the attributes
+// are resolved once so the import does not read the DOM for each JSON object
+struct importTable
+{
+    QString name; //MySQL name
+    QString xmlCode; //ODK name or "main"
+    bool isMain;
+    bool group;
+    bool osm;
+    bool loop;
+    bool hasFieldNodes; //Whether the manifest declares any field for the table
+    QStringList loopItems;
+    QList<TfieldDef> fields; //Fields to insert (referenced fields come as part of the key)
+    QList<TfieldDef> loopFields; //Fields of a loop table
+    QList<int> keyPositions; //Position of the key fields in fields
+    QList<int> children; //Index of the child tables in the plan
+};
+typedef importTable TimportTable;
+
+class importPlan
+{
+public:
+    importPlan();
+    int load(QString manifest);
+    bool isEmpty() const;
+    const TimportTable &root() const;
+    const TimportTable &table(int index) const;
+    int count() const;
+private:
+    int compileTable(QDomNode table);
+    QList<TimportTable> tables;
+};
+
+#endif // IMPORTPLAN_H
@@ -0,0 +1,187 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#include "importstats.h"
+#include <QFile>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+importStats::importStats()
+{
+    bytesRead = 0;
+    files = 0;
+    filesImported = 0;
+    clock.start();
+}
+
+//Adds the time since the phase was started or resumed
+void importStats::charge(TopenPhase &open, qint64 now)
+{
+    qint64 elapsed = now - open.since;
+    phases[open.phase].nsecs += elapsed;
+    if (!open.table.isEmpty())
+        tables[open.table].phases[open.phase].nsecs += elapsed;
+    open.since = now;
+}
+
+//Starts a phase. The current phase is paused until this one ends
+void importStats::begin(const QString &phase, const QString &table)
+{
+    qint64 now = clock.nsecsElapsed();
+    if (!stack.isEmpty())
+        charge(stack.last(), now);
+    TopenPhase open;
+    open.phase = phase;
+    open.table = table;
+    open.since = now;
+    stack.append(open);
+}
+
+void importStats::end()
+{
+    if (stack.isEmpty())
+        return;
+    qint64 now = clock.nsecsElapsed();
+    TopenPhase open = stack.takeLast();
+    charge(open, now);
+    phases[open.phase].calls++;
+    if (!open.table.isEmpty())
+        tables[open.table].phases[open.phase].calls++;
+    if (!stack.isEmpty())
+        stack.last().since = now;
+}
+
+void importStats::addRows(const QString &table, qint64 rows)
+{
+    tables[table].rows += rows;
+}
+
+void importStats::addBytes(qint64 bytes)
+{
+    bytesRead = bytesRead + bytes;
+}
+
+void importStats::addFile(bool imported)
+{
+    files++;
+    if (imported)
+        filesImported++;
+}
+
+void importStats::merge(const importStats &other)
+{
+    QMapIterator<QString, TphaseStat> phase(other.phases);
+    while (phase.hasNext())
+    {
+        phase.next();
+        phases[phase.key()].nsecs += phase.value().nsecs;
+        phases[phase.key()].calls += phase.value().calls;
+    }
+    QMapIterator<QString, TtableStat> table(other.tables);
+    while (table.hasNext())
+    {
+        table.next();
+        TtableStat &stat = tables[table.key()];
+        stat.rows += table.value().rows;
+        QMapIterator<QString, TphaseStat> tablePhase(table.value().phases);
+        while (tablePhase.hasNext())
+        {
+            tablePhase.next();
+            stat.phases[tablePhase.key()].nsecs += tablePhase.value().nsecs;
+            stat.phases[tablePhase.key()].calls += tablePhase.value().calls;
+        }
+    }
+    bytesRead = bytesRead + other.bytesRead;
+    files = files + other.files;
+    filesImported = filesImported + other.filesImported;
+}
+
+QJsonObject importStats::phasesToJSON(const QMap<QString, TphaseStat> &phases)
+{
+    QJsonObject result;
+    QMapIterator<QString, TphaseStat> phase(phases);
+    while (phase.hasNext())
+    {
+        phase.next();
+        QJsonObject stat;
+        stat.insert("time", phase.value().nsecs / 1000000.0);
+        stat.insert("calls", phase.value().calls);
+        result.insert(phase.key(), stat);
+    }
+    return result;
+}
+
+//Times are in milliseconds
+QJsonDocument importStats::toJSON(qint64 wallTime) const
+{
+    QJsonObject root;
+    root.insert("wallTime", wallTime);
+    root.insert("files", files);
+    root.insert("filesImported", filesImported);
+    root.insert("bytesRead", bytesRead);
+#ifdef Q_OS_UNIX
+    //Peak resident set size of the process in KB
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        root.insert("peakRSS", static_cast<qint64>(usage.ru_maxrss));
+#endif
+    root.insert("phases", phasesToJSON(phases));
+    QJsonObject JSONTables;
+    qint64 rows = 0;
+    QMapIterator<QString, TtableStat> table(tables);
+    while (table.hasNext())
+    {
+        table.next();
+        rows = rows + table.value().rows;
+        QJsonObject stat;
+        stat.insert("rows", table.value().rows);
+        stat.insert("phases", phasesToJSON(table.value().phases));
+        JSONTables.insert(table.key(), stat);
+    }
+    root.insert("tables", JSONTables);
+    root.insert("rowsInserted", rows);
+    if (wallTime > 0)
+        root.insert("rowsPerSecond", rows * 1000.0 / wallTime);
+    return QJsonDocument(root);
+}
+
+int importStats::save(QString fileName, qint64 wallTime) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return 1;
+    file.write(toJSON(wallTime).toJson());
+    file.close();
+    return 0;
+}
+
+phaseTimer::phaseTimer(importStats *stats, const QString &phase, const QString &table)
+{
+    this->stats = stats;
+    if (stats != nullptr)
+        stats->begin(phase, table);
+}
+
+phaseTimer::~phaseTimer()
+{
+    if (stats != nullptr)
+        stats->end();
+}
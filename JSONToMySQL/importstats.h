@@ -0,0 +1,90 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#ifndef IMPORTSTATS_H
+#define IMPORTSTATS_H
+
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QJsonDocument>
+
+struct phaseStat
+{
+    qint64 nsecs;
+    qint64 calls;
+};
+typedef phaseStat TphaseStat;
+
+struct tableStat
+{
+    qint64 rows;
+    QMap<QString, TphaseStat> phases;
+};
+typedef tableStat TtableStat;
+
+struct openPhase
+{
+    QString phase;
+    QString table;
+    qint64 since;
+};
+typedef openPhase TopenPhase;
+
+//Wall time and call counts per phase and per table. Phases can be nested and
+//the time of an inner phase is not charged to the outer one.
+//An object must only be used by one thread. Use merge() to combine them.
+class importStats
+{
+public:
+    importStats();
+    void begin(const QString &phase, const QString &table = QString());
+    void end();
+    void addRows(const QString &table, qint64 rows);
+    void addBytes(qint64 bytes);
+    void addFile(bool imported);
+    void merge(const importStats &other);
+    QJsonDocument toJSON(qint64 wallTime) const;
+    int save(QString fileName, qint64 wallTime) const;
+private:
+    void charge(TopenPhase &open, qint64 now);
+    static QJsonObject phasesToJSON(const QMap<QString, TphaseStat> &phases);
+    QElapsedTimer clock;
+    QList<TopenPhase> stack;
+    QMap<QString, TphaseStat> phases;
+    QMap<QString, TtableStat> tables;
+    qint64 bytesRead;
+    qint64 files;
+    qint64 filesImported;
+};
+
+//Times a phase for the scope where it lives. Does nothing if there are no stats
+class phaseTimer
+{
+public:
+    phaseTimer(importStats *stats, const QString &phase, const QString &table = QString());
+    ~phaseTimer();
+private:
+    importStats *stats;
+};
+
+#endif // IMPORTSTATS_H
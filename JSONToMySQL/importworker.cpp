@@ -0,0 +1,1525 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#include "importworker.h"
+#include <QUuid>
+#include <QFileInfo>
+#include <QDomText>
+#include <QBuffer>
+#include <QTemporaryFile>
+
+importWorker::importWorker(QObject *parent)
+    : QThread{parent}
+{
+    status = 0;
+    JSEngine = nullptr;
+    callBeforeInsert = false;
+    callBeforeInsertRows = false;
+    outSQL = false;
+    bulkThreshold = 0;
+    rules = nullptr;
+    stats = nullptr;
+    validator = nullptr;
+    validateCount = 0;
+    batchSize = 1;
+    checkpoint = false;
+    replaying = false;
+    chunkFailed = false;
+    checkpointFatal = false;
+    chunkNumber = 0;
+}
+
+void importWorker::setName(QString name)
+{
+    this->name = name;
+}
+
+void importWorker::setParameters(QString host, QString port, QString user, QString password, QString schema, QString outputType, QString javaScript, bool outSQL, int batchSize, int bulkThreshold, QList<TOSMFileDef> OSMFiles)
+{
+    this->host = host;
+    this->port = port;
+    this->user = user;
+    this->password = password;
+    this->schema = schema;
+    this->outputType = outputType;
+    this->javaScript = javaScript;
+    this->outSQL = outSQL;
+    this->batchSize = batchSize;
+    insertRows.setBatchSize(batchSize);
+    insertRows.setBulkThreshold(bulkThreshold);
+    this->bulkThreshold = bulkThreshold;
+    this->OSMFiles = OSMFiles;
+}
+
+void importWorker::setPlan(const importPlan *plan)
+{
+    this->plan = plan;
+}
+
+void importWorker::setRules(const insertRules *rules)
+{
+    this->rules = rules;
+}
+
+//Only checks the files against the schema. Nothing is inserted
+void importWorker::setValidator(const schemaValidator *validator)
+{
+    this->validator = validator;
+}
+
+//Imports each top-level item of the files in its own transaction. See beginChunk()
+void importWorker::enableCheckpoint()
+{
+    checkpoint = true;
+}
+
+//Collects the time and rows per phase and table. See getStats()
+void importWorker::enableStats()
+{
+    stats = &workerStats;
+    insertRows.setStats(stats);
+}
+
+const importStats &importWorker::getStats() const
+{
+    return workerStats;
+}
+
+void importWorker::setQueue(fileQueue *queue)
+{
+    this->queue = queue;
+}
+
+void importWorker::setOutput(importOutput *output)
+{
+    this->output = output;
+}
+
+//Each worker has its own connection and JavaScript engine and imports files from the queue
+//until it is empty. Each file is imported in its own transaction.
+void importWorker::run()
+{
+    status = 0;
+    sqlStream.setCodec("UTF-8");
+
+    //The engine must live in the thread that uses it
+    JSEngine = new QJSEngine();
+    callBeforeInsert = false;
+    callBeforeInsertRows = false;
+    if (javaScript != "")
+    {
+        QFile scriptFile(javaScript);
+        if (scriptFile.open(QIODevice::ReadOnly))
+        {
+            JSEngine->evaluate(scriptFile.readAll(), javaScript);
+            scriptFile.close();
+            //beforeInsertRows receives all the rows of a table at once and is preferred over beforeInsert
+            beforeInsertRowsFunction = JSEngine->globalObject().property("beforeInsertRows");
+            if (beforeInsertRowsFunction.isCallable())
+                callBeforeInsertRows = true;
+            else
+            {
+                beforeInsertFunction = JSEngine->evaluate("beforeInsert");
+                if (!beforeInsertFunction.isError())
+                    callBeforeInsert = true;
+            }
+        }
+        if ((!callBeforeInsert) && (!callBeforeInsertRows))
+        {
+            log("Error evaluating BeforInsert JS function in " + name);
+            queue->abort();
+            delete JSEngine;
+            JSEngine = nullptr;
+            status = 1;
+            return;
+        }
+    }
+
+    //The validation checks the files against the schema without a connection
+    if (validator != nullptr)
+    {
+        QString jsonFile;
+        while (queue->take(jsonFile))
+            importFile(QSqlDatabase(), jsonFile);
+        delete JSEngine;
+        JSEngine = nullptr;
+        return;
+    }
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QMYSQL",name);
+
+        db.setHostName(host);
+        db.setPort(port.toInt());
+        db.setDatabaseName(schema);
+        db.setUserName(user);
+        db.setPassword(password);
+        //db.setConnectOptions("MYSQL_OPT_SSL_MODE=SSL_MODE_DISABLED");
+        //The bulk mode sends the rows with LOAD DATA LOCAL INFILE
+        if (bulkThreshold > 0)
+            db.setConnectOptions("MYSQL_OPT_LOCAL_INFILE=1");
+        if (db.open())
+        {
+            QString jsonFile;
+            while (queue->take(jsonFile))
+            {
+                if (importFile(db, jsonFile) == 1)
+                {
+                    status = 1;
+                    queue->abort();
+                    break;
+                }
+            }
+            insertRows.reset();
+            db.close();
+        }
+        else
+        {
+            log("Cannot connect to database");
+            log(db.lastError().databaseText());
+            queue->abort();
+            status = 1;
+        }
+    }
+    QSqlDatabase::removeDatabase(name);
+    delete JSEngine;
+    JSEngine = nullptr;
+}
+
+//Serializes a DOM document as UTF-8
+QByteArray importWorker::saveDocument(QDomDocument document)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly | QIODevice::Text);
+    QTextStream out(&buffer);
+    out.setCodec("UTF-8");
+    document.save(out,1,QDomNode::EncodingFromTextStream);
+    out.flush();
+    buffer.close();
+    return data;
+}
+
+//This function imports one JSON file in its own transaction. It returns 0 if the file was imported,
+//2 if the file had errors and was rolled back and 1 if a fatal error happened and the process must stop
+int importWorker::importFile(QSqlDatabase db, QString jsonFile)
+{
+    //Reset the state of the previous file
+    tableIndexes.clear();
+    UUIDList.clear();
+    humanLog = "";
+    recordMap.clear();
+    fileRows.clear();
+    validateGroups.clear();
+    validateIndex.clear();
+    validateCount = 0;
+    chunkNumber = 0;
+    replaying = false;
+    chunkFailed = false;
+    checkpointFatal = false;
+
+    if (outputType != "h")
+    {
+        xmlLog = QDomDocument("XMLErrorLog");
+        QDomElement XMLRoot;
+        XMLRoot = xmlLog.createElement("XMLErrorLog");
+        xmlLog.appendChild(XMLRoot);
+        eErrors = xmlLog.createElement("errors");
+        XMLRoot.appendChild(eErrors);
+    }
+
+    insertRows.clear();
+
+    if (validator == nullptr)
+    {
+        if (!db.transaction())
+        {
+            log("Database does not support transactions");
+            return 1;
+        }
+        //The variable lives in the session so the audit triggers ignore all the inserts of the file
+        QSqlQuery query(db);
+        query.exec("SET @odktools_ignore_insert = 1");
+    }
+
+    if (outSQL)
+    {
+        QFileInfo fi(jsonFile);
+
+        QString outsqlFile;
+        outsqlFile = "./" + fi.fileName() + ".sql";
+
+        sqlFile.setFileName(outsqlFile);
+        if (!sqlFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+            log("Cannot create sqlFile file");
+            if (validator == nullptr)
+                db.rollback();
+            return 1;
+        }
+        sqlStream.setDevice(&sqlFile);
+    }
+
+    if (checkpoint)
+    {
+        if (!checkpointData.open(jsonFile))
+        {
+            log("Cannot open the checkpoint of " + jsonFile);
+            db.rollback();
+            return 1;
+        }
+        if (checkpointData.committedChunks() > 0)
+            log("Resuming " + jsonFile + ". " + QString::number(checkpointData.committedChunks()) + " parts were already imported");
+    }
+
+    SQLErrorNumber = "";
+    SQLError = false;
+    fileError = false;
+    int processError;
+    processError = processFile2(db,jsonFile);
+    if (outSQL)
+    {
+        sqlStream.flush();
+        sqlFile.close();
+    }
+    if (checkpointFatal)
+    {
+        checkpointData.close();
+        return 1;
+    }
+
+    TfileResult result;
+    result.fileName = jsonFile;
+    result.fileID = fileID;
+    result.humanLog = humanLog;
+    if (outputType != "h")
+    {
+        if (!eErrors.firstChild().isNull())
+            result.xmlLog = saveDocument(xmlLog);
+    }
+    if ((SQLError) || (fileError) || (processError == 1))
+    {
+        result.status = 2;
+        if (stats != nullptr)
+            stats->addFile(false);
+        phaseTimer commitTimer(stats, "commit");
+        if ((validator == nullptr) && (!db.rollback()))
+        {
+            log("Error: Rolling back was not possible. Please check the database");
+            return 1;
+        }
+        if (checkpoint)
+        {
+            //The chunks without errors stay in the database and are not imported again
+            if (checkpointData.committedChunks() > 0)
+                log("The parts of " + jsonFile + " without errors were imported. Import it again to retry the rest");
+            checkpointData.close();
+        }
+        phaseTimer outputTimer(stats, "output");
+        if (output->write(result) != 0)
+            return 1;
+        return 2;
+    }
+
+    result.status = 0;
+    result.UUIDs = UUIDList;
+    {
+        phaseTimer mapTimer(stats, "map");
+        result.recordMap = saveDocument(recordMap.toDocument());
+    }
+
+    //Commit the transaction
+    if (validator == nullptr)
+    {
+        phaseTimer commitTimer(stats, "commit");
+        if (!db.commit())
+        {
+            log("Warning: Commit did not succed. Please check the database");
+            log(db.lastError().databaseText());
+            return 1;
+        }
+        //In spool mode the outputs are saved next to the file so they are not lost,
+        //and the file is not imported again, if the process stops before it is moved to done
+        output->markCommitted(result);
+    }
+    //The file is complete so it does not need a checkpoint anymore
+    if (checkpoint)
+        checkpointData.remove();
+    if (stats != nullptr)
+    {
+        //Only the rows of committed files count as inserted
+        stats->addFile(true);
+        QHashIterator<QString, qint64> it(fileRows);
+        while (it.hasNext())
+        {
+            it.next();
+            stats->addRows(it.key(),it.value());
+        }
+    }
+    phaseTimer outputTimer(stats, "output");
+    if (output->write(result) != 0)
+        return 1;
+    return 0;
+}
+
+//Returns the next row index of a table in the file
+int importWorker::getLastIndex(QString table)
+{
+    int &index = tableIndexes[table]; //A new table starts at 0
+    index++;
+    return index;
+}
+
+void importWorker::log(QString message)
+{
+    QString temp;
+    temp = message + "\n";
+    printf("%s",temp.toLocal8Bit().data());
+}
+
+//This function returns a the xmlFieldCode based on its MySQL name
+QString importWorker::getXMLCodeFromField(QList< TfieldDef> fields, QString field)
+{
+    for (int pos = 0; pos <= fields.count()-1;pos++)
+    {
+        if (fields[pos].name == field)
+            return fields[pos].xmlCode;
+    }
+    return "Unknown";
+}
+
+//This procedure creates log entries into the log file for OSM. It used the dictionary tables to retrive a more understanable message.
+void importWorker::logLoopError(QString errorMessage, QString table, QString loopItem, QString execSQL)
+{
+    if (outputType == "h")
+        humanLog += fileID + "\t" + table + "\t" + loopItem + "\t\t" + errorMessage + "\t\t" + execSQL + "\n";
+    else
+    {
+        QDomElement eError;
+        eError = xmlLog.createElement("error");
+        eError.setAttribute("FileUUID",fileID);
+        eError.setAttribute("Table",table);
+        eError.setAttribute("LoopItem",loopItem);
+        eError.setAttribute("JSONVariable","");
+        eError.setAttribute("Error",errorMessage);
+        eError.setAttribute("Notes","");
+        QDomText sqlExecuted;
+        sqlExecuted = xmlLog.createTextNode(execSQL);
+        eError.appendChild(sqlExecuted);
+        eErrors.appendChild(eError);
+    }
+}
+
+//This procedure creates log entries into the log file for OSM. It used the dictionary tables to retrive a more understanable message.
+void importWorker::logOSMError(QString errorMessage, QString table, int nodeIndex, QString execSQL)
+{
+    if (outputType == "h")
+        humanLog += fileID + "\t" + table + "\t" + QString::number(nodeIndex) + "\t\t" + errorMessage + "\t\t" + execSQL + "\n";
+    else
+    {
+        QDomElement eError;
+        eError = xmlLog.createElement("error");
+        eError.setAttribute("FileUUID",fileID);
+        eError.setAttribute("Table",table);
+        eError.setAttribute("Node",QString::number(nodeIndex));
+        eError.setAttribute("JSONVariable","");
+        eError.setAttribute("Error",errorMessage);
+        eError.setAttribute("Notes","");
+        QDomText sqlExecuted;
+        sqlExecuted = xmlLog.createTextNode(execSQL);
+        eError.appendChild(sqlExecuted);
+        eErrors.appendChild(eError);
+    }
+}
+
+//This procedure creates log entries into the log file. It used the dictionary tables to retrive a more understanable message.
+void importWorker::logError(QString errorMessage, QString table, int rowNumber, QString execSQL)
+{    
+    if (outputType == "h")
+        humanLog += fileID + "\t" + table + "\t" + QString::number(rowNumber) + "\t\t" + errorMessage + "\t\t" + execSQL + "\n";
+    else
+    {
+        QDomElement eError;
+        eError = xmlLog.createElement("error");
+        eError.setAttribute("FileUUID",fileID);
+        eError.setAttribute("Table",table);
+        eError.setAttribute("RowInJSON",QString::number(rowNumber));
+        eError.setAttribute("JSONVariable","");
+        eError.setAttribute("Error",errorMessage);
+        eError.setAttribute("Notes","");
+        QDomText sqlExecuted;
+        sqlExecuted = xmlLog.createTextNode(execSQL);
+        eError.appendChild(sqlExecuted);
+        eErrors.appendChild(eError);
+    }
+}
+
+void importWorker::logErrorMSel(QString errorMessage, QString table, int rowNumber, QString execSQL)
+{
+    if (outputType == "h")
+        humanLog += fileID + "\t" + table + "\t" + QString::number(rowNumber) + "\t\t" + errorMessage + "\t\t" + execSQL + "\n";
+    else
+    {
+        QDomElement eError;
+        eError = xmlLog.createElement("error");
+        eError.setAttribute("FileUUID",fileID);
+        eError.setAttribute("Table",table);
+        eError.setAttribute("RowInJSON",QString::number(rowNumber));
+        eError.setAttribute("JSONVariable","");
+        eError.setAttribute("Error",errorMessage);
+        eError.setAttribute("Notes","");
+        eError.setNodeValue(execSQL);
+        eErrors.appendChild(eError);
+    }
+}
+
+//This function stores data in the record map
+void importWorker::storeRecord(QStringList parentUUIDS, QString recordUUID)
+{
+    QStringList split;
+    split = recordUUID.split("~");
+    if (parentUUIDS.isEmpty())
+        recordMap.addRecord(split[0],split[1]);
+    else
+    {
+        QStringList parentSplit;
+        parentSplit = parentUUIDS[parentUUIDS.count()-1].split("~");
+        recordMap.addRecord(parentSplit[1],split[0],split[1]);
+    }
+}
+
+//This function constructs the rows of a JSON object and buffers them to be inserted into the database.
+QList<TfieldDef > importWorker::createSQL(QSqlDatabase db, const QJsonObject &jsonData, QString table, const QList< TfieldDef> &fields, QList< TfieldDef> parentkeys, const QJsonObject &jsonData2, bool mTable)
+{
+    QVariant variantValue;
+    int pos;
+
+    QList<TfieldDef > resKeys;
+
+    phaseTimer buildTimer(stats, "build", table);
+
+    QString fieldValue;
+    insertValues insertObject;
+    int tblIndex;
+    tblIndex = getLastIndex(table);
+
+    QString strRecordUUID=newRowUUID();
+
+    for (pos = 0; pos <= parentkeys.count()-1;pos++)
+    {
+        //sqlHeader = sqlHeader + parentkeys[pos].name + ",";
+        //sqlValues = sqlValues + "'" + parentkeys[pos].value + "',";
+        TinsertValueDef insValue;
+        insValue.key = true;
+        insValue.name = parentkeys[pos].name;
+        insValue.value = parentkeys[pos].value;
+        insValue.xmlCode = parentkeys[pos].xmlCode;
+        insValue.multiSelect = parentkeys[pos].multiSelect;
+        insValue.multiSelectTable = parentkeys[pos].multiSelectTable;
+        insValue.insert = true;
+        insertObject.insertValue(insValue);
+    }
+    for (pos = 0; pos <= fields.count()-1;pos++)
+    {
+        // If a new key is found in the list of fields
+        // then we added to the result of keys that will be passes to any possible child table
+        if (fields[pos].key == true)
+        {            
+            TfieldDef key;
+            key.key = true;
+            key.name = fields[pos].name;
+            key.xmlCode = fields[pos].xmlCode;
+            key.multiSelect = fields[pos].multiSelect;
+            key.multiSelectTable = fields[pos].multiSelectTable;
+            key.value = jsonData.value(fields[pos].xmlCode).toVariant().toString();
+            key.value = key.value.simplified();
+            if (fields[pos].type == "datetime")
+            {
+                if (key.value.indexOf(".") >= 0)
+                {
+                    QStringList parts;
+                    parts = key.value.split(".");
+                    key.value = parts[0];
+                    key.value = key.value.replace("T"," ");
+                    key.value = key.value.replace("Z","");
+                    if (fields[pos].ODKType == "time")
+                    {
+                        if (key.value.indexOf("-") < 0)
+                        {
+                            //Treat time as datetime by fixing date a date
+                            key.value = "2019-01-01 " + key.value;
+                        }
+                    }
+                }
+            }
+            key.uuid = table + "~" + strRecordUUID;
+
+            // If its empty. The try to find it in jsonData2
+            // This happens when the cover information is stored in a repeat of one
+            // so part of the information for the main table must be searched in jsonData
+            // and part in jsonData2
+            if (key.value.isEmpty())
+            {
+                key.value = jsonData2.value(fields[pos].xmlCode).toVariant().toString();
+                key.value = key.value.simplified();
+            }
+
+            //If the key is empty (Normal as in the JSON such key does not exist) set the key value to tblIndex
+            if (key.value.isEmpty())
+            {
+                if (!mTable)
+                {
+                    key.value = QString::number(tblIndex);
+                    //sqlHeader = sqlHeader + key.name + ",";
+                    //sqlValues = sqlValues + "'" + QString::number(tblIndex) + "',";
+                }
+                else
+                {
+                    key.value = "";
+                    //sqlHeader = sqlHeader + key.name + ",";
+                    //sqlValues = sqlValues + "'',";
+                }
+            }
+            else
+            {
+                //sqlHeader = sqlHeader + key.name + ",";
+                //sqlValues = sqlValues + "'" + fixString(key.value) + "',";
+            }
+            //Append the key to the list of returned keys
+            //key.value = key.value;
+
+            resKeys.append(key);
+            insertObject.insertValue(key.name,key.xmlCode,key.value,key.key,false,key.multiSelectTable);
+        }
+        else
+        {
+            TinsertValueDef insValue;
+            insValue.key = false;
+            insValue.name = fields[pos].name;
+            insValue.xmlCode = fields[pos].xmlCode;
+            insValue.insert = true;
+            insValue.multiSelect = fields[pos].multiSelect;
+            insValue.multiSelectTable = fields[pos].multiSelectTable;
+
+            //sqlHeader = sqlHeader + fields[pos].name + ",";
+            variantValue =  jsonData.value(fields[pos].xmlCode).toVariant();
+            fieldValue = QString::fromUtf8(variantValue.toByteArray());
+
+            if (fields[pos].name == "originid")
+            {
+                //sqlValues = sqlValues + "'ODKTOOLS',";
+                fieldValue = "ODKTOOLS 2.0";
+            }
+            if (fields[pos].name == "surveyid")
+            {
+              //sqlValues = sqlValues + "'" + fileID + "',";
+              fieldValue = fileID;
+            }
+            if (fields[pos].type == "datetime")
+            {
+                if (fieldValue.indexOf(".") >= 0)
+                {
+                    QStringList parts;
+                    parts = fieldValue.split(".");
+                    fieldValue = parts[0];
+                    fieldValue = fieldValue.replace("T"," ");
+                    fieldValue = fieldValue.replace("Z","");                    
+                    if (fields[pos].ODKType == "time")
+                    {
+                        if (fieldValue.indexOf("-") < 0)
+                        {
+                            //Treat time as datetime by fixing date a date
+                            fieldValue = "2019-01-01 " + fieldValue;
+                        }
+                    }
+                }
+            }            
+            insValue.value = fieldValue;
+            insertObject.insertValue(insValue);
+        }
+    }
+
+    //Apply the declarative rules before the JavaScript so the script sees the final values
+    if (rules != nullptr)
+        rules->apply(table,insertObject);
+
+    //We have all the insert values, Now we pass such values along with the table name to the external javaScript if its defined to allow custom modifications
+    //to the values before we insert them into the mysql database
+    if (callBeforeInsert)
+    {
+        phaseTimer JSTimer(stats, "javascript", table);
+        QJSValue insertListObj = JSEngine->newQObject(&insertObject);
+        QJSValue result = beforeInsertFunction.call(QJSValueList() << table << insertListObj);
+        if (result.isError())
+        {
+            log("Error calling BeforInsert JS function with table " + table + ". The insert may end up in error. The script will not be loaded again.");
+            callBeforeInsert = false;
+        }
+    }
+
+    TbufferedRow row;
+    row.table = table;
+    for (pos = 0; pos < insertObject.count();pos++)
+    {
+        if ((insertObject.itemName(pos) != "rowuuid") && (insertObject.itemToInsert(pos) || insertObject.itemIsKey(pos)))
+        {
+            row.columns.append(insertObject.itemName(pos));
+            row.values.append(SQLValue(insertObject.itemValue(pos)));
+        }
+
+        // Key values could have changed by the external JavaScript so
+        // update resKeys with the current values
+        if (insertObject.itemIsKey(pos) == true)
+        {
+            for (int rkey = 0; rkey < resKeys.count(); rkey++)
+            {
+                if (resKeys[rkey].name.toLower().simplified() == insertObject.itemName(pos).toLower().simplified())
+                {
+                    resKeys[rkey].value = insertObject.itemValue(pos);
+                }
+            }
+        }
+    }
+    row.columns.append("rowuuid");
+    row.values.append(strRecordUUID);
+    row.rowUUID = strRecordUUID;
+    row.logType = 1;
+    row.logRow = tblIndex;
+    row.storeInMap = true;
+    row.storeUUID = true;
+    //The record is stored in the map under its parent
+    for (int nkey = 0; nkey <= parentkeys.count()-1;nkey++)
+    {
+        if (row.mapParents.indexOf(parentkeys[nkey].uuid) == -1)
+            row.mapParents.append(parentkeys[nkey].uuid);
+    }
+    addRow(db,row);
+
+    //Now we process the MultiSelects
+    QList<TinsertValueDef> currentKeys;
+    currentKeys.append(insertObject.getKeys());
+    QString mSelectTableName;
+    QStringList mSelectValues;
+    int nkey;
+    int nvalue;
+    for (pos = 0; pos < insertObject.count();pos++)
+    {
+        if (insertObject.itemIsMultiSelect(pos) == true)
+        {
+            mSelectTableName = insertObject.itemMultiSelectTable(pos);
+
+            mSelectValues.clear();
+            //Split the values into a stringlist
+            mSelectValues.append(insertObject.itemValue(pos).simplified().split(" ",QString::SkipEmptyParts));
+            //Process each value
+            for (nvalue = 0; nvalue < mSelectValues.count();nvalue++)
+            {
+                insertValues multiSelectObject; //Each value creates a new multiSelectObject
+                //Insert the current keys to the multiSelectObject object
+                for (nkey = 0; nkey < currentKeys.count();nkey++)
+                {
+                    multiSelectObject.insertValue(currentKeys[nkey]);
+                }
+                //Insert the value to the multiSelectObject
+                multiSelectObject.insertValue(insertObject.itemName(pos),"",mSelectValues[nvalue],true);
+
+                if (rules != nullptr)
+                    rules->apply(mSelectTableName,multiSelectObject);
+
+                //Here we should pass the value to the JavaScript function
+
+                if (callBeforeInsert)
+                {
+                    phaseTimer JSTimer(stats, "javascript", mSelectTableName);
+                    QJSValue insertListObj = JSEngine->newQObject(&multiSelectObject);
+                    QJSValue result = beforeInsertFunction.call(QJSValueList() << mSelectTableName << insertListObj);
+                    if (result.isError())
+                    {
+                        log("Error calling BeforInsert JS function with table " + mSelectTableName + ". The insert may end up in error. The script will not be loaded again.");
+                        callBeforeInsert = false;
+                    }
+                }
+
+                //Create the insert
+                QString uuidstr=newRowUUID();
+                TbufferedRow mSelRow;
+                mSelRow.table = mSelectTableName;
+                for (nkey = 0; nkey < multiSelectObject.count();nkey++)
+                {
+                    if ((multiSelectObject.itemName(nkey) != "rowuuid") && (multiSelectObject.itemToInsert(nkey) || multiSelectObject.itemIsKey(nkey)))
+                    {
+                        mSelRow.columns.append(multiSelectObject.itemName(nkey));
+                        mSelRow.values.append(SQLValue(multiSelectObject.itemValue(nkey)));
+                    }
+                }
+                mSelRow.columns.append("rowuuid");
+                mSelRow.values.append(uuidstr);
+                mSelRow.rowUUID = uuidstr;
+                mSelRow.logType = 2;
+                mSelRow.logRow = tblIndex;
+                mSelRow.storeInMap = true;
+                mSelRow.mapParents.append(table + "~" + strRecordUUID);
+                mSelRow.storeUUID = true;
+                addRow(db,mSelRow);
+            }
+        }
+    }
+
+    return resKeys;
+}
+
+//Empty values are inserted as NULL. This minimize foreign key errors in skips
+QVariant importWorker::SQLValue(const QString &value)
+{
+    if (value.isEmpty())
+        return QVariant(QVariant::String);
+    return QVariant(value);
+}
+
+//Buffers a row to be inserted with the next flush
+void importWorker::addRow(QSqlDatabase db, const TbufferedRow &row)
+{
+    if (validator != nullptr)
+    {
+        if (!callBeforeInsertRows)
+        {
+            validateRow(row);
+            return;
+        }
+        //The rows are checked after beforeInsertRows changes them, in the same groups as in an import
+        QString signature = row.table + "(" + row.columns.join(",") + ")";
+        int index = validateIndex.value(signature, -1);
+        if (index == -1)
+        {
+            TrowGroup group;
+            group.signature = signature;
+            group.tableOrder = validateGroups.count();
+            validateGroups.append(group);
+            index = validateGroups.count() - 1;
+            validateIndex.insert(signature, index);
+        }
+        validateGroups[index].rows.append(row);
+        validateCount++;
+        if (validateCount >= batchSize)
+            validateBuffered();
+        return;
+    }
+    if (replaying)
+    {
+        //The row is already in the database. Only the record map and the UUIDs are rebuilt
+        rowInserted(row);
+        return;
+    }
+    if (outSQL)
+    {
+        sqlStream << insertBuffer::renderSQL(row) + ";\n";
+    }
+    insertRows.addRow(row);
+    if (insertRows.isFull())
+        flushRows(db, false);
+}
+
+//Inserts the buffered rows and stores the ones inserted in the record map and the UUIDs list.
+//If not all, the tables after the one that reached the bulk threshold stay in the buffer
+void importWorker::flushRows(QSqlDatabase db, bool all)
+{
+    if (validator != nullptr)
+    {
+        validateBuffered();
+        return;
+    }
+    if (insertRows.isEmpty())
+        return;
+    QList<TinsertResult> results;
+    if (callBeforeInsertRows)
+        results = insertRows.flush(db,this,all);
+    else
+        results = insertRows.flush(db,nullptr,all);
+    for (int pos = 0; pos < results.count(); pos++)
+    {
+        const TbufferedRow &row = results[pos].row;
+        if (results[pos].inserted)
+        {
+            if (stats != nullptr)
+                fileRows[row.table]++;
+            rowInserted(row);
+        }
+        else
+        {
+            SQLError = true; //An error occurred. This will trigger a rollback
+            if (SQLErrorNumber == "")
+                SQLErrorNumber = results[pos].nativeErrorCode + "&"  + results[pos].error + "@" + row.table;
+            if (row.logType == 1)
+                logError(results[pos].error,row.table,row.logRow,results[pos].sql);
+            if (row.logType == 2)
+                logErrorMSel(results[pos].error,row.table,row.logRow,results[pos].sql);
+            if (row.logType == 3)
+                logLoopError(results[pos].error,row.table,row.logItem,results[pos].sql);
+            if (row.logType == 4)
+                logOSMError(results[pos].error,row.table,row.logRow,results[pos].sql);
+        }
+    }
+}
+
+//Checks the values of a row against the schema and logs the errors as the insert would do
+//Passes the rows waiting in -V mode to beforeInsertRows and checks them
+void importWorker::validateBuffered()
+{
+    for (int pos = 0; pos < validateGroups.count(); pos++)
+    {
+        transformRows(validateGroups[pos].rows[0].table, validateGroups[pos].rows);
+        for (int row = 0; row < validateGroups[pos].rows.count(); row++)
+            validateRow(validateGroups[pos].rows[row]);
+    }
+    validateGroups.clear();
+    validateIndex.clear();
+    validateCount = 0;
+}
+
+void importWorker::validateRow(const TbufferedRow &row)
+{
+    phaseTimer validateTimer(stats, "validate", row.table);
+    QString error;
+    for (int pos = 0; pos < row.columns.count(); pos++)
+    {
+        if (!validator->checkValue(row.table,row.columns[pos],row.values[pos],error))
+        {
+            SQLError = true;
+            QString sql = insertBuffer::renderSQL(row);
+            if (row.logType == 1)
+                logError(error,row.table,row.logRow,sql);
+            if (row.logType == 2)
+                logErrorMSel(error,row.table,row.logRow,sql);
+            if (row.logType == 3)
+                logLoopError(error,row.table,row.logItem,sql);
+            if (row.logType == 4)
+                logOSMError(error,row.table,row.logRow,sql);
+            return;
+        }
+    }
+}
+
+//Stores an inserted row in the record map and the UUIDs list
+void importWorker::rowInserted(const TbufferedRow &row)
+{
+    if (row.storeInMap)
+        storeRecord(row.mapParents,row.table + "~" + row.rowUUID);
+    if (row.storeUUID)
+        UUIDList.append(row.table + "," + row.rowUUID);
+}
+
+//Returns the UUID of a new row. A chunk committed by a previous run gets the same UUIDs it had
+QString importWorker::newRowUUID()
+{
+    if (replaying)
+    {
+        if (replayPos < replayUUIDs.count())
+        {
+            replayPos++;
+            return replayUUIDs[replayPos-1];
+        }
+        replayPos++; //The file has more rows than when the chunk was committed
+    }
+    QUuid recordUUID=QUuid::createUuid();
+    QString strRecordUUID=recordUUID.toString().replace("{","").replace("}","");
+    if (checkpoint)
+        chunkUUIDs.append(strRecordUUID);
+    return strRecordUUID;
+}
+
+//In checkpoint mode the root row and each top-level repeat item are a chunk imported in
+//its own transaction. A chunk committed by a previous run is replayed: Its rows are created
+//again with the same keys and UUIDs to rebuild the record map but are not inserted.
+void importWorker::beginChunk()
+{
+    if (!checkpoint)
+        return;
+    chunkUUIDs.clear();
+    chunkUUIDMark = UUIDList.count();
+    chunkMapMark = recordMap.count();
+    chunkFileRows = fileRows;
+    chunkSQLError = SQLError;
+    chunkFileError = fileError;
+    SQLError = false;
+    fileError = false;
+    if (checkpointData.isCommitted(chunkNumber))
+    {
+        replaying = true;
+        replayUUIDs = checkpointData.UUIDs(chunkNumber);
+        replayPos = 0;
+    }
+}
+
+//Commits the chunk and records it in the checkpoint file. A chunk with errors is rolled back
+//(chunkFailed) and the rest of the file continues. Returns 1 if the database cannot continue
+int importWorker::endChunk(QSqlDatabase db)
+{
+    chunkFailed = false;
+    if (!checkpoint)
+        return 0;
+    if (replaying)
+    {
+        replaying = false;
+        if (replayPos != replayUUIDs.count())
+        {
+            log("Error: The checkpoint of " + fileID + " does not match the file. Remove the .checkpoint file to import it again");
+            fileError = true;
+            chunkFailed = true;
+        }
+    }
+    else
+    {
+        flushRows(db);
+        phaseTimer commitTimer(stats, "commit");
+        if ((SQLError) || (fileError))
+        {
+            if (!db.rollback())
+            {
+                log("Error: Rolling back was not possible. Please check the database");
+                return 1;
+            }
+            UUIDList = UUIDList.mid(0,chunkUUIDMark);
+            recordMap.truncate(chunkMapMark);
+            fileRows = chunkFileRows;
+            chunkFailed = true;
+        }
+        else
+        {
+            if (!db.commit())
+            {
+                log("Warning: Commit did not succed. Please check the database");
+                log(db.lastError().databaseText());
+                return 1;
+            }
+            if (!checkpointData.commitChunk(chunkNumber,chunkUUIDs))
+                log("Warning: Cannot write the checkpoint of " + fileID);
+        }
+        if (!db.transaction())
+        {
+            log("Database does not support transactions");
+            return 1;
+        }
+    }
+    SQLError = SQLError || chunkSQLError;
+    fileError = fileError || chunkFileError;
+    chunkNumber++;
+    return 0;
+}
+
+//Passes all the buffered rows of a table to the beforeInsertRows JavaScript function in one call.
+//The rows are an array of objects (column:value) that the function can change in place or return.
+//Loop and OSM rows are not passed to the script as it happens with beforeInsert.
+void importWorker::transformRows(const QString &table, QList<TbufferedRow> &rows)
+{
+    if ((!callBeforeInsertRows) || (rows.isEmpty()))
+        return;
+    if (rows[0].logType >= 3)
+        return;
+    phaseTimer JSTimer(stats, "javascript", table);
+    QVariantList JSRows;
+    for (int pos = 0; pos < rows.count(); pos++)
+    {
+        QVariantMap JSRow;
+        for (int col = 0; col < rows[pos].columns.count(); col++)
+        {
+            if (rows[pos].columns[col] != "rowuuid")
+                JSRow.insert(rows[pos].columns[col],rows[pos].values[col]);
+        }
+        JSRows.append(JSRow);
+    }
+    QJSValue JSArray = JSEngine->toScriptValue(JSRows);
+    QJSValue result = beforeInsertRowsFunction.call(QJSValueList() << table << JSArray);
+    if (result.isError())
+    {
+        log("Error calling beforeInsertRows JS function with table " + table + ". The insert may end up in error. The script will not be loaded again.");
+        callBeforeInsertRows = false;
+        return;
+    }
+    if (result.isArray())
+        JSArray = result;
+    QVariantList newRows = JSArray.toVariant().toList();
+    if (newRows.count() != rows.count())
+    {
+        log("Error: beforeInsertRows changed the number of rows of table " + table + ". The changes are ignored.");
+        return;
+    }
+    for (int pos = 0; pos < rows.count(); pos++)
+    {
+        QVariantMap JSRow = newRows[pos].toMap();
+        rows[pos].columns.clear();
+        rows[pos].values.clear();
+        QMapIterator<QString, QVariant> it(JSRow);
+        while (it.hasNext())
+        {
+            it.next();
+            if (it.key() != "rowuuid")
+            {
+                rows[pos].columns.append(it.key());
+                rows[pos].values.append(SQLValue(it.value().toString()));
+            }
+        }
+        rows[pos].columns.append("rowuuid");
+        rows[pos].values.append(rows[pos].rowUUID);
+    }
+}
+
+void importWorker::debugKeys(QString table, QList< TfieldDef> keys)
+{
+    qDebug() << "***" + table;
+    qDebug() << "Total keys: " + QString::number(keys.count());
+    for (int pos = 0; pos <= keys.count()-1;pos++)
+    {
+        qDebug() << "Field:" + keys[pos].name + ". Value: " + keys[pos].value;
+    }
+
+}
+
+void importWorker::debugMap(QVariantMap jsonData)
+{
+
+    QList<QString > keys;
+    keys = jsonData.keys();
+    qDebug() << "-----------------------------------------";
+    for (int pos = 0; pos <= keys.count()-1;pos++)
+    {
+        qDebug() << keys[pos] << " : " << jsonData.value(keys[pos]).toString();
+    }
+}
+
+QString  importWorker::fixField(QString source)
+{
+    QString res;
+    res = source;
+    res = res.replace("'","");
+    res = res.replace('\"',"");
+    res = res.replace(";","");
+    res = res.replace("-","_");
+    res = res.replace(",","");
+    res = res.replace(" ","");
+    res = res.replace(".","_");
+    res = res.replace(":","");
+    res = res.trimmed().simplified().toLower();
+    return res;
+}
+
+void importWorker::insertOSMData(QString OSMField, const QString &lat, const QString &lon, int nodeIndex, const QList<TOSMTag> &tags, QList< TfieldDef> parentkeys, QSqlDatabase db)
+{
+    QString strRecordUUID=newRowUUID();
+
+    TbufferedRow row;
+    row.table = OSMField;
+    for (int ikey = 0; ikey < parentkeys.count(); ikey++)
+    {
+        row.columns.append(parentkeys[ikey].name);
+        row.values.append(parentkeys[ikey].value);
+    }
+    row.columns.append(OSMField + "_rowid");
+    row.values.append(QString::number(nodeIndex));
+    row.columns.append("geopoint_lat");
+    row.values.append(lat);
+    row.columns.append("geopoint_lon");
+    row.values.append(lon);
+    for (int itag = 0; itag < tags.count(); itag++)
+    {
+        row.columns.append(fixField(tags[itag].key));
+        row.values.append(tags[itag].value);
+    }
+    row.columns.append("rowuuid");
+    row.values.append(strRecordUUID);
+    row.rowUUID = strRecordUUID;
+    row.logType = 4;
+    row.logRow = nodeIndex;
+    row.storeInMap = false;
+    row.storeUUID = true;
+    addRow(db,row);
+}
+
+//Reads the nodes of an OSM file as a stream so the memory does not depend on the number of nodes.
+//Each node is buffered as a row and sent with the rest of the rows of the file
+void importWorker::processOSM(QString OSMField, QString OSMFile, QList< TfieldDef> parentkeys, QSqlDatabase db)
+{    
+    QString filePath = "";
+    for (int idx=0; idx < OSMFiles.count(); idx++)
+    {
+        if (OSMFiles[idx].baseName == OSMFile)
+        {
+            filePath = OSMFiles[idx].fileName;
+            break;
+        }
+
+    }
+    if (filePath != "")
+    {
+        phaseTimer OSMTimer(stats, "osm", OSMField);
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            log("Cannot open OSM file \"" + OSMFile + "\"");
+            fileError = true;
+            return;
+        }
+        QXmlStreamReader xml(&file);
+        int nodeIndex = 0;
+        bool inNode = false;
+        QString lat;
+        QString lon;
+        QList<TOSMTag> tags;
+        while (!xml.atEnd())
+        {
+            xml.readNext();
+            if (xml.isStartElement())
+            {
+                if (xml.name() == QLatin1String("node"))
+                {
+                    inNode = true;
+                    nodeIndex++;
+                    lat = xml.attributes().value("lat").toString();
+                    lon = xml.attributes().value("lon").toString();
+                    tags.clear();
+                }
+                else
+                {
+                    if (inNode && (xml.name() == QLatin1String("tag")))
+                    {
+                        if (xml.attributes().hasAttribute("k"))
+                        {
+                            TOSMTag tag;
+                            tag.key = xml.attributes().value("k").toString();
+                            tag.value = xml.attributes().value("v").toString();
+                            tags.append(tag);
+                        }
+                    }
+                }
+            }
+            if (xml.isEndElement() && (xml.name() == QLatin1String("node")))
+            {
+                inNode = false;
+                insertOSMData(OSMField, lat, lon, nodeIndex, tags, parentkeys, db);
+            }
+        }
+        file.close();
+        if (xml.hasError())
+        {
+            log("Cannot parse OSM file \"" + OSMFile + "\". " + xml.errorString());
+            fileError = true;
+        }
+    }
+    else
+    {
+        log("OSM file \"" + OSMFile + "\" was not attached. Attach it and run the tool again");
+        fileError = true;
+    }
+}
+
+void importWorker::processLoop(QJsonObject jsonData, QString loopTable, QString loopXMLRoot, const QStringList &loopItems, const QList< TfieldDef> &fields, QList< TfieldDef> parentkeys, QSqlDatabase db)
+{
+    for (int iItem = 0; iItem < loopItems.count(); iItem++)
+    {
+        QString strRecordUUID=newRowUUID();
+
+        TbufferedRow row;
+        row.table = loopTable;
+        for (int ikey = 0; ikey < parentkeys.count(); ikey++)
+        {
+            row.columns.append(parentkeys[ikey].name);
+            row.values.append(parentkeys[ikey].value);
+        }
+        row.columns.append(loopTable);
+        row.values.append(loopItems[iItem]);
+        for (int iField = 0; iField < fields.count(); iField++)
+        {
+            QString fieldValue;
+            QString xmlKey = loopXMLRoot + "/" + loopItems[iItem] + "/" + fields[iField].xmlCode;
+            fieldValue = jsonData.value(xmlKey).toString("");
+            if (fields[iField].type == "datetime")
+            {
+                if (fieldValue.indexOf(".") >= 0)
+                {
+                    QStringList parts;
+                    parts = fieldValue.split(".");
+                    fieldValue = parts[0];
+                    fieldValue = fieldValue.replace("T"," ");
+                    fieldValue = fieldValue.replace("Z","");
+                    if (fields[iField].ODKType == "time")
+                    {
+                        if (fieldValue.indexOf("-") < 0)
+                        {
+                            //Treat time as datetime by fixing date a date
+                            fieldValue = "2019-01-01 " + fieldValue;
+                        }
+                    }
+                }
+            }
+            row.columns.append(fields[iField].name);
+            row.values.append(fieldValue);
+        }
+        row.columns.append("rowuuid");
+        row.values.append(strRecordUUID);
+        row.rowUUID = strRecordUUID;
+        row.logType = 3;
+        row.logRow = iItem + 1;
+        row.logItem = loopItems[iItem];
+        row.storeInMap = false;
+        row.storeUUID = true;
+        addRow(db,row);
+
+        for (int pos = 0; pos < fields.count(); pos++)
+        {
+            if (fields[pos].multiSelect == true)
+            {
+                QString fieldValue;
+                QString xmlKey = loopXMLRoot + "/" + loopItems[iItem] + "/" + fields[pos].xmlCode;
+                fieldValue = jsonData.value(xmlKey).toString("");
+                QStringList parts = fieldValue.split(" ",QString::SkipEmptyParts);
+                for (int ipart = 0; ipart < parts.count(); ipart++)
+                {
+                    strRecordUUID=newRowUUID();
+                    TbufferedRow mSelRow;
+                    mSelRow.table = fields[pos].multiSelectTable;
+                    for (int ikey = 0; ikey < parentkeys.count(); ikey++)
+                    {
+                        mSelRow.columns.append(parentkeys[ikey].name);
+                        mSelRow.values.append(parentkeys[ikey].value);
+                    }
+                    mSelRow.columns.append(loopTable);
+                    mSelRow.values.append(loopItems[iItem]);
+                    mSelRow.columns.append(fields[pos].name);
+                    mSelRow.values.append(parts[ipart]);
+                    mSelRow.columns.append("rowuuid");
+                    mSelRow.values.append(strRecordUUID);
+                    mSelRow.rowUUID = strRecordUUID;
+                    mSelRow.logType = 3;
+                    mSelRow.logRow = iItem + 1;
+                    mSelRow.logItem = loopItems[iItem] + "-" + parts[ipart];
+                    mSelRow.storeInMap = false;
+                    mSelRow.storeUUID = false;
+                    addRow(db,mSelRow);
+                }
+            }
+        }
+    }
+}
+
+//Imports a JSON object using a compiled table of the plan. Main tables and groups insert one row
+//from jsonData while repeats insert one row for each item in the array of the table.
+int importWorker::procTable2(QSqlDatabase db, const QJsonObject &jsonData, const TimportTable &table, QList< TfieldDef> parentkeys)
+{
+    QList< TfieldDef> keys;
+    keys.append(parentkeys);
+
+    QJsonObject emptyObject;
+    if (table.osm)
+    {
+        QString OSMFile = jsonData.value(table.xmlCode).toString("");
+        if (OSMFile != "")
+            processOSM(table.name,OSMFile,keys,db);
+        return 0;
+    }
+    if (table.loop)
+    {
+        if (table.loopItems.count() > 0)
+            processLoop(jsonData,table.name,table.xmlCode,table.loopItems,table.loopFields,keys,db);
+        return 0;
+    }
+
+    if ((table.isMain) || (table.group))
+    {
+        if (table.children.isEmpty())
+            createSQL(db,jsonData,table.name,table.fields,keys,emptyObject,true);
+        else
+        {
+            if (table.hasFieldNodes)
+                keys.append(createSQL(db,jsonData,table.name,table.fields,keys,emptyObject,true));
+            for (int chld = 0; chld < table.children.count(); chld++)
+                procTable2(db,jsonData,plan->table(table.children[chld]),keys);
+        }
+    }
+    else
+    {
+        QJsonArray JSONArray;
+        JSONArray = jsonData.value(table.xmlCode).toArray();
+        for (int item = 0; item < JSONArray.count(); item++) //For each item in the array
+            procRepeatItem(db,JSONArray[item].toObject(),table,keys);
+    }
+    return 0;
+}
+
+//Imports one item of a repeat and its child tables
+void importWorker::procRepeatItem(QSqlDatabase db, const QJsonObject &JSONItem, const TimportTable &table, const QList< TfieldDef> &parentkeys)
+{
+    QJsonObject emptyObject;
+    QList< TfieldDef> tkeys;
+    tkeys.append(parentkeys);
+    tkeys.append(createSQL(db,JSONItem,table.name,table.fields,tkeys,emptyObject,false));
+    for (int chld = 0; chld < table.children.count(); chld++)
+        procTable2(db,JSONItem,plan->table(table.children[chld]),tkeys);
+}
+
+//Imports the tables that use the first JSON object: The main table, its groups and their OSM and loop tables.
+//The repeats found are not imported but registered, in the order of the manifest, so their items can be read one by one.
+void importWorker::procRootTable(QSqlDatabase db, const QJsonObject &rootData, const TimportTable &table, QList< TfieldDef> parentkeys, QList<TrepeatTarget> &repeats)
+{
+    if ((table.osm) || (table.loop))
+    {
+        procTable2(db,rootData,table,parentkeys);
+        return;
+    }
+    if ((table.isMain) || (table.group))
+    {
+        QList< TfieldDef> keys;
+        keys.append(parentkeys);
+        QJsonObject emptyObject;
+        if (table.children.isEmpty())
+            createSQL(db,rootData,table.name,table.fields,keys,emptyObject,true);
+        else
+        {
+            if (table.hasFieldNodes)
+                keys.append(createSQL(db,rootData,table.name,table.fields,keys,emptyObject,true));
+            for (int chld = 0; chld < table.children.count(); chld++)
+                procRootTable(db,rootData,plan->table(table.children[chld]),keys,repeats);
+        }
+        return;
+    }
+    TrepeatTarget target;
+    target.table = &table;
+    target.keys = parentkeys;
+    repeats.append(target);
+}
+
+//Reads the JSON file once. The values of the first object are kept in memory and the arrays are
+//copied as they are to a spool file, so the main table can be imported when all its values are
+//known whatever the order of the keys. Then the items of the repeats are read from the spool one at a
+//time, in the order of the manifest. Peak memory depends on the size of an item and not on the size of the file
+int importWorker::processFile2(QSqlDatabase db, QString json)
+{
+    QFileInfo fi(json);
+    //If the file hasn't been processed yet
+
+
+    fileID = fi.baseName();
+
+    //The time to read the JSON. The processing of the tables is charged to their own phases
+    phaseTimer parseTimer(stats, "parse");
+    jsonStreamReader reader;
+    if (!reader.open(json))
+    {
+        log("Cannot open" + json);
+        return 1;
+    }
+    if (!reader.beginObject())
+    {
+        reader.close();
+        return 0;
+    }
+    QJsonObject rootData;
+    QTemporaryFile spool;
+    QHash<QString, qint64> arrays; //Position of each array in the spool
+    QString key;
+    while (reader.nextKey(key))
+    {
+        if (reader.isArray())
+        {
+            if ((!spool.isOpen()) && (!spool.open()))
+            {
+                log("Cannot create a temporary file to read " + json);
+                reader.close();
+                return 1;
+            }
+            arrays.insert(key, spool.pos());
+            if (!reader.copyValue(&spool))
+                break;
+        }
+        else
+            rootData.insert(key,reader.readValue());
+    }
+    if (reader.hasError())
+    {
+        log("Cannot parse " + json);
+        reader.close();
+        return 1;
+    }
+    if (stats != nullptr)
+        stats->addBytes(reader.bytesRead());
+    reader.close();
+    if ((rootData.isEmpty()) && (arrays.isEmpty()))
+        return 0;
+
+    //Process the first table with no parent Keys
+    QList< TfieldDef> noParentKeys;
+    QList<TrepeatTarget> repeats;
+    beginChunk();
+    procRootTable(db,rootData,plan->root(),noParentKeys,repeats);
+    if (endChunk(db) != 0)
+    {
+        checkpointFatal = true;
+        return 1;
+    }
+    //The items of the repeats need the main row. Without it each item would only fail on its foreign key
+    if (chunkFailed)
+    {
+        log("The main row of " + json + " was not imported. Its repeats are skipped");
+        return 1;
+    }
+
+    if (!arrays.isEmpty() && !repeats.isEmpty())
+    {
+        if (!spool.flush())
+        {
+            log("Cannot write the temporary file to read " + json);
+            return 1;
+        }
+        jsonStreamReader items;
+        if (!items.open(spool.fileName()))
+        {
+            log("Cannot read the temporary file to read " + json);
+            return 1;
+        }
+        for (int pos = 0; pos < repeats.count(); pos++)
+        {
+            if (!arrays.contains(repeats[pos].table->xmlCode))
+                continue;
+            items.seek(arrays.value(repeats[pos].table->xmlCode));
+            items.beginArray();
+            while (items.nextElement())
+            {
+                QJsonObject JSONItem = items.readValue().toObject();
+                if (items.hasError())
+                    break;
+                beginChunk();
+                procRepeatItem(db,JSONItem,*repeats[pos].table,repeats[pos].keys);
+                if (endChunk(db) != 0)
+                {
+                    checkpointFatal = true;
+                    items.close();
+                    return 1;
+                }
+            }
+            if (items.hasError())
+            {
+                log("Cannot parse " + json);
+                items.close();
+                return 1;
+            }
+        }
+        items.close();
+    }
+    flushRows(db);
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#ifndef IMPORTWORKER_H
+#define IMPORTWORKER_H
+
+#include <QThread>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVariantList>
+#include <QVariant>
+#include <QtXml>
+#include <QList>
+#include <QHash>
+#include <QJSEngine>
+#include <QJSValue>
+#include <QJSValueList>
+#include <QDomDocument>
+#include <QDomElement>
+#include <QDomNodeList>
+#include <QXmlStreamReader>
+#include "insertvalues.h"
+#include "importplan.h"
+#include "insertbuffer.h"
+#include "insertrules.h"
+#include "importstats.h"
+#include "checkpointfile.h"
+#include "schemavalidator.h"
+#include "importoutput.h"
+#include "filequeue.h"
+#include "recordtree.h"
+#include "jsonstreamreader.h"
+
+struct OSMFileDef
+{
+    QString fileName;
+    QString baseName;
+};
+typedef OSMFileDef TOSMFileDef;
+
+struct OSMTag
+{
+    QString key;
+    QString value;
+};
+typedef OSMTag TOSMTag;
+
+//A repeat of the first JSON object and the keys of its parent row
+struct repeatTarget
+{
+    const TimportTable *table;
+    QList<TfieldDef> keys;
+};
+typedef repeatTarget TrepeatTarget;
+
+class importWorker : public QThread, public rowTransformer
+{
+    Q_OBJECT
+public:
+    explicit importWorker(QObject *parent = nullptr);
+    void run();
+    void setName(QString name);
+    void setParameters(QString host, QString port, QString user, QString password, QString schema, QString outputType, QString javaScript, bool outSQL, int batchSize, int bulkThreshold, QList<TOSMFileDef> OSMFiles);
+    void setPlan(const importPlan *plan);
+    void setRules(const insertRules *rules);
+    void enableStats();
+    void enableCheckpoint();
+    void setValidator(const schemaValidator *validator);
+    const importStats &getStats() const;
+    void setQueue(fileQueue *queue);
+    void transformRows(const QString &table, QList<TbufferedRow> &rows);
+    void setOutput(importOutput *output);
+    int status;
+private:
+    void logLoopError(QString errorMessage, QString table, QString loopItem, QString execSQL);
+    void processLoop(QJsonObject jsonData, QString loopTable, QString loopXMLRoot, const QStringList &loopItems, const QList< TfieldDef> &fields, QList< TfieldDef> parentkeys, QSqlDatabase db);
+    QString fixField(QString source);
+    void logOSMError(QString errorMessage, QString table, int nodeIndex, QString execSQL);
+    void insertOSMData(QString OSMField, const QString &lat, const QString &lon, int nodeIndex, const QList<TOSMTag> &tags, QList< TfieldDef> parentkeys, QSqlDatabase db);
+    void processOSM(QString OSMField, QString OSMFile, QList< TfieldDef> parentkeys, QSqlDatabase db);
+    int getLastIndex(QString table);
+    void log(QString message);
+    QString getXMLCodeFromField(QList< TfieldDef> fields, QString field);
+    void logError(QString errorMessage, QString table, int rowNumber, QString execSQL);
+    void logErrorMSel(QString errorMessage, QString table, int rowNumber, QString execSQL);
+    QVariant SQLValue(const QString &value);
+    void addRow(QSqlDatabase db, const TbufferedRow &row);
+    void flushRows(QSqlDatabase db, bool all = true);
+    void rowInserted(const TbufferedRow &row);
+    void validateRow(const TbufferedRow &row);
+    void validateBuffered();
+    QString newRowUUID();
+    void beginChunk();
+    int endChunk(QSqlDatabase db);
+    QList<TfieldDef > createSQL(QSqlDatabase db, const QJsonObject &jsonData, QString table, const QList< TfieldDef> &fields, QList< TfieldDef> parentkeys, const QJsonObject &jsonData2, bool mTable);
+    void debugKeys(QString table, QList< TfieldDef> keys);
+    void debugMap(QVariantMap jsonData);
+    int procTable2(QSqlDatabase db, const QJsonObject &jsonData, const TimportTable &table, QList< TfieldDef> parentkeys);
+    void procRepeatItem(QSqlDatabase db, const QJsonObject &JSONItem, const TimportTable &table, const QList< TfieldDef> &parentkeys);
+    void procRootTable(QSqlDatabase db, const QJsonObject &rootData, const TimportTable &table, QList< TfieldDef> parentkeys, QList<TrepeatTarget> &repeats);
+    int processFile2(QSqlDatabase db, QString json);
+    int importFile(QSqlDatabase db, QString jsonFile);
+    QByteArray saveDocument(QDomDocument document);
+    void storeRecord(QStringList parentUUIDS, QString recordUUID);
+
+    QJSValue beforeInsertFunction;
+    bool callBeforeInsert;
+    QJSValue beforeInsertRowsFunction;
+    bool callBeforeInsertRows;
+    const insertRules *rules;
+    importStats workerStats;
+    importStats *stats;
+    QHash<QString, qint64> fileRows; //Rows inserted per table in the current file
+    const schemaValidator *validator;
+    //Rows waiting for beforeInsertRows in -V mode, grouped as insertBuffer does
+    QList<TrowGroup> validateGroups;
+    QHash<QString, int> validateIndex;
+    int validateCount;
+    int batchSize;
+    //Checkpoint mode
+    bool checkpoint;
+    checkpointFile checkpointData;
+    int chunkNumber;
+    bool replaying;
+    QStringList replayUUIDs;
+    int replayPos;
+    QStringList chunkUUIDs;
+    int chunkUUIDMark;
+    int chunkMapMark;
+    QHash<QString, qint64> chunkFileRows;
+    bool chunkSQLError;
+    bool chunkFileError;
+    bool chunkFailed;
+    bool checkpointFatal;
+    QHash<QString, int> tableIndexes;
+
+    bool SQLError;
+    bool fileError;
+    QString SQLErrorNumber;
+    QString fileID;
+
+    //Huma logging
+    QString humanLog;
+    //Machine loggin
+    QDomDocument xmlLog;
+    QDomElement eErrors;
+
+    insertBuffer insertRows;
+
+    bool outSQL;
+    int bulkThreshold;
+    QFile sqlFile;
+    QTextStream sqlStream;
+    recordTree recordMap;
+    QStringList UUIDList;
+
+    QJSEngine *JSEngine;
+
+    const importPlan *plan;
+    fileQueue *queue;
+    importOutput *output;
+
+    //Run parameters
+    QString name;
+    QString host;
+    QString port;
+    QString user;
+    QString password;
+    QString schema;
+    QString javaScript;
+    QString outputType;
+    QList<TOSMFileDef> OSMFiles;
+};
+
+#endif // IMPORTWORKER_H
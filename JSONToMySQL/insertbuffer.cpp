@@ -0,0 +1,416 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#include "insertbuffer.h"
+#include <QSqlError>
+#include <QTemporaryFile>
+#include <algorithm>
+
+//MySQL does not allow more than 65535 placeholders in a prepared statement
+#define MAX_PLACEHOLDERS 65000
+//In bulk mode the buffer is flushed when it holds this many times the bulk threshold even if no table
+//reached it, so the memory is bounded when the rows are spread over many tables
+#define BULK_BUFFER_FACTOR 4
+
+static bool groupLessThan(const TrowGroup &a, const TrowGroup &b)
+{
+    return a.tableOrder < b.tableOrder;
+}
+
+insertBuffer::insertBuffer()
+{
+    batchSize = 500;
+    bulkThreshold = 0;
+    bulkEnabled = true;
+    bufferedRows = 0;
+    bulkOrder = -1;
+    stats = nullptr;
+}
+
+void insertBuffer::setBatchSize(int rows)
+{
+    if (rows < 1)
+        rows = 1;
+    batchSize = rows;
+}
+
+void insertBuffer::addRow(const TbufferedRow &row)
+{
+    // Parent tables always receive their first row before their child tables
+    // so the order in which tables are seen is used to flush parents first
+    if (!tableOrder.contains(row.table))
+        tableOrder.insert(row.table, tableOrder.count());
+    QString signature = row.table + "(" + row.columns.join(",") + ")";
+    int index = groupIndex.value(signature, -1);
+    if (index == -1)
+    {
+        TrowGroup group;
+        group.signature = signature;
+        group.tableOrder = tableOrder.value(row.table);
+        index = groups.count();
+        groups.append(group);
+        groupIndex.insert(signature, index);
+    }
+    groups[index].rows.append(row);
+    bufferedRows++;
+    int rows = tableRows.value(row.table, 0) + 1;
+    tableRows.insert(row.table, rows);
+    if ((bulkThreshold > 0) && (rows >= bulkThreshold))
+        bulkOrder = qMax(bulkOrder, tableOrder.value(row.table));
+}
+
+//Groups with at least this number of rows are inserted with LOAD DATA LOCAL INFILE. 0 disables it
+void insertBuffer::setBulkThreshold(int rows)
+{
+    if (rows < 0)
+        rows = 0;
+    bulkThreshold = rows;
+}
+
+//Times the execution of each table. nullptr disables it
+void insertBuffer::setStats(importStats *stats)
+{
+    this->stats = stats;
+}
+
+bool insertBuffer::isFull() const
+{
+    //In bulk mode the rows are kept until one table reaches the threshold. The rows of
+    //parent and child tables are usually interleaved so the total is not a good measure
+    if ((bulkThreshold > 0) && bulkEnabled)
+        return (bulkOrder >= 0) || (bufferedRows >= bulkThreshold * BULK_BUFFER_FACTOR);
+    return bufferedRows >= batchSize;
+}
+
+bool insertBuffer::isEmpty() const
+{
+    return bufferedRows == 0;
+}
+
+//Renders a row as a SQL INSERT. Used for the SQL output file and the error log
+QString insertBuffer::renderSQL(const TbufferedRow &row)
+{
+    QString sql;
+    sql = "INSERT INTO " + row.table + " (" + row.columns.join(",") + ") VALUES (";
+    for (int pos = 0; pos < row.values.count(); pos++)
+    {
+        if (row.values[pos].isNull())
+            sql = sql + "NULL";
+        else
+        {
+            QString value = row.values[pos].toString();
+            sql = sql + "'" + value.replace("\\","\\\\").replace("'","''") + "'";
+        }
+        if (pos < row.values.count()-1)
+            sql = sql + ",";
+    }
+    sql = sql + ")";
+    return sql;
+}
+
+bool insertBuffer::getStatement(QSqlDatabase db, const TbufferedRow &row, const QString &signature, int rows, QSqlQuery &query)
+{
+    QString key = signature + "#" + QString::number(rows);
+    if (statements.contains(key))
+    {
+        query = statements.value(key);
+        return true;
+    }
+    QString placeHolders;
+    placeHolders = "(" + QString("?,").repeated(row.columns.count());
+    placeHolders = placeHolders.left(placeHolders.length()-1) + ")";
+    QString sql;
+    sql = "INSERT INTO " + row.table + " (" + row.columns.join(",") + ") VALUES ";
+    for (int pos = 0; pos < rows; pos++)
+    {
+        sql = sql + placeHolders;
+        if (pos < rows-1)
+            sql = sql + ",";
+    }
+    QSqlQuery newQuery(db);
+    if (!newQuery.prepare(sql))
+    {
+        query = newQuery;
+        return false;
+    }
+    statements.insert(key, newQuery);
+    query = newQuery;
+    return true;
+}
+
+//Inserts one row. Used when a multi-row statement fails to find which rows are in error
+void insertBuffer::execRow(QSqlDatabase db, const TbufferedRow &row, const QString &signature, QList<TinsertResult> &results)
+{
+    TinsertResult result;
+    result.row = row;
+    QSqlQuery query;
+    bool ok = getStatement(db, row, signature, 1, query);
+    if (ok)
+    {
+        for (int pos = 0; pos < row.values.count(); pos++)
+            query.bindValue(pos, row.values[pos]);
+        ok = query.exec();
+    }
+    result.inserted = ok;
+    if (!ok)
+    {
+        result.error = query.lastError().databaseText();
+        result.nativeErrorCode = query.lastError().nativeErrorCode();
+        result.sql = renderSQL(row);
+    }
+    results.append(result);
+}
+
+void insertBuffer::execGroup(QSqlDatabase db, const TrowGroup &group, QList<TinsertResult> &results)
+{
+    int columns = group.rows[0].columns.count();
+    int rowsPerStatement = qMin(batchSize, MAX_PLACEHOLDERS / columns);
+    if (rowsPerStatement < 1)
+        rowsPerStatement = 1;
+    int start = 0;
+    while (start < group.rows.count())
+    {
+        int rows = qMin(rowsPerStatement, group.rows.count() - start);
+        QSqlQuery query;
+        bool ok = getStatement(db, group.rows[start], group.signature, rows, query);
+        if (ok)
+        {
+            int placeHolder = 0;
+            for (int row = start; row < start + rows; row++)
+            {
+                for (int pos = 0; pos < group.rows[row].values.count(); pos++)
+                {
+                    query.bindValue(placeHolder, group.rows[row].values[pos]);
+                    placeHolder++;
+                }
+            }
+            ok = query.exec();
+        }
+        if (ok)
+        {
+            for (int row = start; row < start + rows; row++)
+            {
+                TinsertResult result;
+                result.row = group.rows[row];
+                result.inserted = true;
+                results.append(result);
+            }
+        }
+        else
+        {
+            //The statement is atomic so none of the rows were inserted.
+            //Insert them one by one to report the ones in error
+            for (int row = start; row < start + rows; row++)
+                execRow(db, group.rows[row], group.signature, results);
+        }
+        start = start + rows;
+    }
+}
+
+//Escapes a value for the tab separated file used by LOAD DATA
+static void appendBulkValue(QByteArray &line, const QVariant &value)
+{
+    if (value.isNull())
+    {
+        line.append("\\N");
+        return;
+    }
+    QByteArray data = value.toString().toUtf8();
+    for (int pos = 0; pos < data.size(); pos++)
+    {
+        char c = data.at(pos);
+        switch (c)
+        {
+        case '\\':
+            line.append("\\\\");
+            break;
+        case '\t':
+            line.append("\\t");
+            break;
+        case '\n':
+            line.append("\\n");
+            break;
+        case '\r':
+            line.append("\\r");
+            break;
+        case '\0':
+            line.append("\\0");
+            break;
+        default:
+            line.append(c);
+        }
+    }
+}
+
+//Inserts a group of rows staging them in a temporary file and pushing it with LOAD DATA LOCAL INFILE.
+//With LOCAL the server ignores duplicates and converts errors into warnings so the load runs
+//inside a savepoint and is undone if any row was skipped or changed. Returns false in such case
+//so the rows are inserted again with INSERTs to report the ones in error.
+bool insertBuffer::execBulk(QSqlDatabase db, const TrowGroup &group, QList<TinsertResult> &results)
+{
+    QTemporaryFile file;
+    if (!file.open())
+        return false;
+    QByteArray line;
+    for (int row = 0; row < group.rows.count(); row++)
+    {
+        line.clear();
+        for (int pos = 0; pos < group.rows[row].values.count(); pos++)
+        {
+            if (pos > 0)
+                line.append('\t');
+            appendBulkValue(line, group.rows[row].values[pos]);
+        }
+        line.append('\n');
+        if (file.write(line) != line.size())
+            return false;
+    }
+    if (!file.flush())
+        return false;
+
+    QSqlQuery query(db);
+    if (!query.exec("SAVEPOINT odktools_bulk"))
+        return false;
+    QString sql;
+    sql = "LOAD DATA LOCAL INFILE '" + file.fileName().replace("\\","\\\\").replace("'","''") + "'";
+    sql = sql + " INTO TABLE " + group.rows[0].table + " CHARACTER SET utf8mb4";
+    sql = sql + " FIELDS TERMINATED BY '\\t' ESCAPED BY '\\\\' LINES TERMINATED BY '\\n'";
+    sql = sql + " (" + group.rows[0].columns.join(",") + ")";
+    bool ok = query.exec(sql);
+    if (!ok)
+    {
+        //Error 1148/2068/3948: The client or the server do not allow LOCAL. Use INSERTs from now on
+        QString error = query.lastError().nativeErrorCode();
+        if ((error == "1148") || (error == "2068") || (error == "3948"))
+            bulkEnabled = false;
+    }
+    if (ok)
+        ok = (query.numRowsAffected() == group.rows.count());
+    if (ok)
+    {
+        ok = query.exec("SELECT @@warning_count");
+        if (ok && query.next())
+            ok = (query.value(0).toInt() == 0);
+    }
+    if (!ok)
+    {
+        query.exec("ROLLBACK TO SAVEPOINT odktools_bulk");
+        return false;
+    }
+    query.exec("RELEASE SAVEPOINT odktools_bulk");
+    for (int row = 0; row < group.rows.count(); row++)
+    {
+        TinsertResult result;
+        result.row = group.rows[row];
+        result.inserted = true;
+        results.append(result);
+    }
+    return true;
+}
+
+//Inserts a group using LOAD DATA if it is big enough or multi-row INSERTs otherwise
+void insertBuffer::insertGroup(QSqlDatabase db, const TrowGroup &group, QList<TinsertResult> &results)
+{
+    phaseTimer timer(stats, "execute", group.rows[0].table);
+    if ((bulkThreshold > 0) && bulkEnabled && (group.rows.count() >= bulkThreshold))
+    {
+        if (execBulk(db, group, results))
+            return;
+    }
+    execGroup(db, group, results);
+}
+
+//Inserts the buffered rows. Parent tables are inserted before their children.
+//If not all, and a table reached the bulk threshold, only that table and the ones seen
+//before it (which include all its parents) are inserted. The rest stay in the buffer
+//so they can also reach the threshold
+QList<TinsertResult> insertBuffer::flush(QSqlDatabase db, rowTransformer *transformer, bool all)
+{
+    QList<TinsertResult> results;
+    std::stable_sort(groups.begin(), groups.end(), groupLessThan);
+    int lastOrder = -1;
+    if ((!all) && (bulkOrder >= 0))
+        lastOrder = bulkOrder;
+    QList<TrowGroup> kept;
+    for (int pos = 0; pos < groups.count(); pos++)
+    {
+        if ((lastOrder >= 0) && (groups[pos].tableOrder > lastOrder))
+        {
+            kept.append(groups[pos]);
+            continue;
+        }
+        tableRows.remove(groups[pos].rows[0].table);
+        if (transformer == nullptr)
+        {
+            insertGroup(db, groups[pos], results);
+            continue;
+        }
+        transformer->transformRows(groups[pos].rows[0].table, groups[pos].rows);
+        // The transformer may add or remove columns so the rows are grouped again
+        QList<TrowGroup> subGroups;
+        QHash<QString, int> subGroupIndex;
+        for (int row = 0; row < groups[pos].rows.count(); row++)
+        {
+            const TbufferedRow &bRow = groups[pos].rows[row];
+            QString signature = bRow.table + "(" + bRow.columns.join(",") + ")";
+            int index = subGroupIndex.value(signature, -1);
+            if (index == -1)
+            {
+                TrowGroup group;
+                group.signature = signature;
+                group.tableOrder = groups[pos].tableOrder;
+                index = subGroups.count();
+                subGroups.append(group);
+                subGroupIndex.insert(signature, index);
+            }
+            subGroups[index].rows.append(bRow);
+        }
+        for (int sub = 0; sub < subGroups.count(); sub++)
+            insertGroup(db, subGroups[sub], results);
+    }
+    groups = kept;
+    groupIndex.clear();
+    for (int pos = 0; pos < groups.count(); pos++)
+        groupIndex.insert(groups[pos].signature, pos);
+    bufferedRows = 0;
+    for (int pos = 0; pos < groups.count(); pos++)
+        bufferedRows = bufferedRows + groups[pos].rows.count();
+    bulkOrder = -1;
+    return results;
+}
+
+//Removes the buffered rows. The table order and the prepared statements are kept
+void insertBuffer::clear()
+{
+    groups.clear();
+    groupIndex.clear();
+    tableRows.clear();
+    bufferedRows = 0;
+    bulkOrder = -1;
+}
+
+//Removes everything. Must be called before the connection is closed
+void insertBuffer::reset()
+{
+    clear();
+    tableOrder.clear();
+    statements.clear();
+    bulkEnabled = true;
+}
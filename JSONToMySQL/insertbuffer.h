@@ -0,0 +1,112 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#ifndef INSERTBUFFER_H
+#define INSERTBUFFER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVariantList>
+#include <QList>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "importstats.h"
+
+//A row waiting to be inserted into the database
+struct bufferedRow
+{
+    QString table;
+    QStringList columns; //Columns to insert. rowuuid is the last one
+    QVariantList values; //A null value is inserted as NULL
+    QString rowUUID;
+    int logType; //1 = Table row, 2 = Multi-select row, 3 = Loop row, 4 = OSM node
+    int logRow; //Row in JSON (node index for OSM nodes) used in the error log
+    QString logItem; //Loop item used in the error log of loop rows
+    bool storeInMap; //Whether to store the row in the record map
+    QStringList mapParents; //UUIDs (table~uuid) of the parents in the record map
+    bool storeUUID; //Whether to store the UUID in the UUIDs file
+};
+typedef bufferedRow TbufferedRow;
+
+struct insertResult
+{
+    TbufferedRow row;
+    bool inserted;
+    QString error;
+    QString nativeErrorCode;
+    QString sql;
+};
+typedef insertResult TinsertResult;
+
+struct rowGroup
+{
+    QString signature;
+    int tableOrder;
+    QList<TbufferedRow> rows;
+};
+typedef rowGroup TrowGroup;
+
+//Receives the rows of a table just before they are inserted so they can be changed in bulk
+class rowTransformer
+{
+public:
+    virtual ~rowTransformer() {}
+    virtual void transformRows(const QString &table, QList<TbufferedRow> &rows) = 0;
+};
+
+//Collects the rows of a submission per table and column set and inserts them
+//using prepared multi-row INSERTs. Statements are prepared once and reused.
+//Big groups can be pushed with LOAD DATA LOCAL INFILE (see setBulkThreshold)
+class insertBuffer
+{
+public:
+    insertBuffer();
+    void setBatchSize(int rows);
+    void setBulkThreshold(int rows);
+    void setStats(importStats *stats);
+    void addRow(const TbufferedRow &row);
+    bool isFull() const;
+    bool isEmpty() const;
+    QList<TinsertResult> flush(QSqlDatabase db, rowTransformer *transformer = nullptr, bool all = true);
+    void clear();
+    void reset();
+    static QString renderSQL(const TbufferedRow &row);
+private:
+    bool getStatement(QSqlDatabase db, const TbufferedRow &row, const QString &signature, int rows, QSqlQuery &query);
+    void execGroup(QSqlDatabase db, const TrowGroup &group, QList<TinsertResult> &results);
+    bool execBulk(QSqlDatabase db, const TrowGroup &group, QList<TinsertResult> &results);
+    void insertGroup(QSqlDatabase db, const TrowGroup &group, QList<TinsertResult> &results);
+    void execRow(QSqlDatabase db, const TbufferedRow &row, const QString &signature, QList<TinsertResult> &results);
+    QList<TrowGroup> groups;
+    QHash<QString, int> groupIndex;
+    QHash<QString, int> tableOrder;
+    QHash<QString, QSqlQuery> statements;
+    int batchSize;
+    int bulkThreshold;
+    bool bulkEnabled;
+    importStats *stats;
+    int bufferedRows;
+    QHash<QString, int> tableRows; //Buffered rows of each table
+    int bulkOrder; //Order of the last table that reached the bulk threshold. -1 if none
+};
+
+#endif // INSERTBUFFER_H
@@ -0,0 +1,125 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#include "insertrules.h"
+#include <QFile>
+#include <QDomDocument>
+
+insertRules::insertRules()
+{
+    hasAllTables = false;
+}
+
+void insertRules::loadTable(QDomElement eTable, TtableRules &rules)
+{
+    QDomElement eRule = eTable.firstChildElement();
+    while (!eRule.isNull())
+    {
+        QString column = eRule.attribute("column","").toLower().simplified();
+        if (column != "")
+        {
+            if (eRule.tagName() == "remap")
+                rules.remaps[column].insert(eRule.attribute("from",""),eRule.attribute("to",""));
+            if (eRule.tagName() == "set")
+                rules.constants.insert(column,eRule.attribute("value",""));
+            if (eRule.tagName() == "drop")
+                rules.drops.insert(column);
+        }
+        eRule = eRule.nextSiblingElement();
+    }
+}
+
+//Loads a rules file like:
+//<insertRules>
+//  <table name="maintable">
+//    <remap column="sex" from="M" to="1"/>
+//    <set column="originid" value="FORMSHARE"/>
+//    <drop column="comments"/>
+//  </table>
+//</insertRules>
+//A table named "*" applies to all the tables. Returns 0 if the file was loaded.
+int insertRules::load(QString rulesFile)
+{
+    QDomDocument doc("rules");
+    QFile xmlfile(rulesFile);
+    if (!xmlfile.open(QIODevice::ReadOnly))
+        return 1;
+    if (!doc.setContent(&xmlfile))
+    {
+        xmlfile.close();
+        return 1;
+    }
+    xmlfile.close();
+
+    QDomElement eTable = doc.documentElement().firstChildElement("table");
+    while (!eTable.isNull())
+    {
+        QString name = eTable.attribute("name","").toLower().simplified();
+        if (name == "*")
+        {
+            hasAllTables = true;
+            loadTable(eTable, allTables);
+        }
+        else
+        {
+            if (name != "")
+                loadTable(eTable, tables[name]);
+        }
+        eTable = eTable.nextSiblingElement("table");
+    }
+    return 0;
+}
+
+bool insertRules::isEmpty() const
+{
+    return tables.isEmpty() && !hasAllTables;
+}
+
+static void applyTableRules(const TtableRules &rules, insertValues &values)
+{
+    for (int pos = 0; pos < values.count(); pos++)
+    {
+        QString column = values.itemName(pos).toLower().simplified();
+        if (rules.drops.contains(column) && (!values.itemIsKey(pos))) //Keys are always inserted
+            values.setItemToInsert(pos,false);
+        if (rules.constants.contains(column))
+            values.setItemValue(pos,rules.constants.value(column));
+        else
+        {
+            QHash<QString, QHash<QString, QString> >::const_iterator remap = rules.remaps.constFind(column);
+            if (remap != rules.remaps.constEnd())
+            {
+                QString value = values.itemValue(pos);
+                if (remap.value().contains(value))
+                    values.setItemValue(pos,remap.value().value(value));
+            }
+        }
+    }
+}
+
+//Applies the rules of a table to the values of a row
+void insertRules::apply(const QString &table, insertValues &values) const
+{
+    if (hasAllTables)
+        applyTableRules(allTables, values);
+    QHash<QString, TtableRules>::const_iterator it = tables.constFind(table.toLower());
+    if (it != tables.constEnd())
+        applyTableRules(it.value(), values);
+}
@@ -0,0 +1,54 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#ifndef INSERTRULES_H
+#define INSERTRULES_H
+
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QDomElement>
+#include "insertvalues.h"
+
+struct tableRules
+{
+    QHash<QString, QHash<QString, QString> > remaps; //column -> (value -> new value)
+    QHash<QString, QString> constants; //column -> value
+    QSet<QString> drops; //columns not to insert
+};
+typedef tableRules TtableRules;
+
+//Declarative transformations applied to the values before they are inserted.
+//They cover the common uses of the beforeInsert JavaScript without calling the JavaScript engine.
+class insertRules
+{
+public:
+    insertRules();
+    int load(QString rulesFile);
+    bool isEmpty() const;
+    void apply(const QString &table, insertValues &values) const;
+private:
+    void loadTable(QDomElement eTable, TtableRules &rules);
+    QHash<QString, TtableRules> tables;
+    TtableRules allTables;
+    bool hasAllTables;
+};
+
+#endif // INSERTRULES_H
@@ -0,0 +1,366 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#include "jsonstreamreader.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonParseError>
+
+#define READ_BUFFER_SIZE 65536
+
+jsonStreamReader::jsonStreamReader()
+{
+    bufferPos = 0;
+    capturing = false;
+    copyDevice = nullptr;
+    error = false;
+    totalRead = 0;
+}
+
+bool jsonStreamReader::open(QString fileName)
+{
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    buffer.clear();
+    bufferPos = 0;
+    capturing = false;
+    error = false;
+    totalRead = 0;
+    firstItem.clear();
+    return true;
+}
+
+//Goes back to the start of the file. The bytes read start again from 0
+bool jsonStreamReader::rewind()
+{
+    if (!seek(0))
+        return false;
+    totalRead = 0;
+    return true;
+}
+
+//Moves to a position of the file where a value starts
+bool jsonStreamReader::seek(qint64 pos)
+{
+    if (!file.seek(pos))
+        return false;
+    buffer.clear();
+    bufferPos = 0;
+    capturing = false;
+    error = false;
+    firstItem.clear();
+    return true;
+}
+
+void jsonStreamReader::close()
+{
+    file.close();
+    buffer.clear();
+}
+
+bool jsonStreamReader::fillBuffer()
+{
+    if (bufferPos < buffer.size())
+        return true;
+    buffer = file.read(READ_BUFFER_SIZE);
+    bufferPos = 0;
+    totalRead = totalRead + buffer.size();
+    return !buffer.isEmpty();
+}
+
+bool jsonStreamReader::peekChar(char &c)
+{
+    if (!fillBuffer())
+        return false;
+    c = buffer.at(bufferPos);
+    return true;
+}
+
+bool jsonStreamReader::getChar(char &c)
+{
+    if (!fillBuffer())
+    {
+        error = true;
+        return false;
+    }
+    c = buffer.at(bufferPos);
+    bufferPos++;
+    if (capturing)
+    {
+        capture.append(c);
+        if ((copyDevice != nullptr) && (capture.size() >= READ_BUFFER_SIZE))
+        {
+            if (copyDevice->write(capture) != capture.size())
+                error = true;
+            capture.clear();
+        }
+    }
+    return true;
+}
+
+bool jsonStreamReader::expect(char c)
+{
+    char current;
+    if (!getChar(current))
+        return false;
+    if (current != c)
+    {
+        error = true;
+        return false;
+    }
+    return true;
+}
+
+void jsonStreamReader::skipWhiteSpace()
+{
+    char c;
+    while (peekChar(c))
+    {
+        if ((c != ' ') && (c != '\t') && (c != '\r') && (c != '\n'))
+            return;
+        bufferPos++;
+    }
+}
+
+//Consumes a string. The opening quote is the next character
+void jsonStreamReader::scanString()
+{
+    char c;
+    if (!expect('"'))
+        return;
+    while (getChar(c))
+    {
+        if (c == '\\')
+        {
+            if (!getChar(c))
+                return;
+        }
+        else
+        {
+            if (c == '"')
+                return;
+        }
+    }
+}
+
+//Consumes one value of any type
+void jsonStreamReader::scanValue()
+{
+    char c;
+    skipWhiteSpace();
+    if (!peekChar(c))
+    {
+        error = true;
+        return;
+    }
+    if (c == '"')
+    {
+        scanString();
+        return;
+    }
+    if ((c == '{') || (c == '['))
+    {
+        getChar(c);
+        int depth = 1;
+        while ((depth > 0) && !error)
+        {
+            if (!peekChar(c))
+            {
+                error = true;
+                return;
+            }
+            if (c == '"')
+                scanString();
+            else
+            {
+                getChar(c);
+                if ((c == '{') || (c == '['))
+                    depth++;
+                if ((c == '}') || (c == ']'))
+                    depth--;
+            }
+        }
+        return;
+    }
+    //Numbers, true, false and null
+    while (peekChar(c))
+    {
+        if ((c == ',') || (c == '}') || (c == ']') || (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n'))
+            return;
+        getChar(c);
+    }
+}
+
+bool jsonStreamReader::beginObject()
+{
+    skipWhiteSpace();
+    char c;
+    if (!peekChar(c) || (c != '{'))
+        return false;
+    getChar(c);
+    firstItem.append(true);
+    return true;
+}
+
+bool jsonStreamReader::beginArray()
+{
+    skipWhiteSpace();
+    char c;
+    if (!peekChar(c) || (c != '['))
+        return false;
+    getChar(c);
+    firstItem.append(true);
+    return true;
+}
+
+//Moves to the next key of the current object. Returns false at the end of the object
+bool jsonStreamReader::nextKey(QString &key)
+{
+    if (error || firstItem.isEmpty())
+        return false;
+    skipWhiteSpace();
+    char c;
+    if (!peekChar(c))
+    {
+        error = true;
+        return false;
+    }
+    if (c == '}')
+    {
+        getChar(c);
+        firstItem.removeLast();
+        return false;
+    }
+    if (!firstItem.last())
+    {
+        if (!expect(','))
+            return false;
+        skipWhiteSpace();
+    }
+    firstItem.last() = false;
+    capture.clear();
+    capturing = true;
+    scanString();
+    capturing = false;
+    if (error)
+        return false;
+    QJsonDocument keyDoc = QJsonDocument::fromJson("[" + capture + "]");
+    key = keyDoc.array().at(0).toString();
+    skipWhiteSpace();
+    if (!expect(':'))
+        return false;
+    skipWhiteSpace();
+    return true;
+}
+
+//Moves to the next element of the current array. Returns false at the end of the array
+bool jsonStreamReader::nextElement()
+{
+    if (error || firstItem.isEmpty())
+        return false;
+    skipWhiteSpace();
+    char c;
+    if (!peekChar(c))
+    {
+        error = true;
+        return false;
+    }
+    if (c == ']')
+    {
+        getChar(c);
+        firstItem.removeLast();
+        return false;
+    }
+    if (!firstItem.last())
+    {
+        if (!expect(','))
+            return false;
+        skipWhiteSpace();
+    }
+    firstItem.last() = false;
+    return true;
+}
+
+bool jsonStreamReader::isArray()
+{
+    skipWhiteSpace();
+    char c;
+    if (!peekChar(c))
+        return false;
+    return c == '[';
+}
+
+//Reads the current value into memory
+QJsonValue jsonStreamReader::readValue()
+{
+    capture.clear();
+    capturing = true;
+    scanValue();
+    capturing = false;
+    if (error)
+        return QJsonValue();
+    QJsonParseError parseError;
+    QJsonValue res;
+    if (capture.startsWith('{'))
+        res = QJsonDocument::fromJson(capture, &parseError).object();
+    else
+    {
+        if (capture.startsWith('['))
+            res = QJsonDocument::fromJson(capture, &parseError).array();
+        else
+            res = QJsonDocument::fromJson("[" + capture + "]", &parseError).array().at(0);
+    }
+    if (parseError.error != QJsonParseError::NoError)
+        error = true;
+    capture.clear();
+    return res;
+}
+
+void jsonStreamReader::skipValue()
+{
+    scanValue();
+}
+
+//Copies the text of the current value to a device without keeping it in memory
+bool jsonStreamReader::copyValue(QIODevice *device)
+{
+    capture.clear();
+    capturing = true;
+    copyDevice = device;
+    scanValue();
+    capturing = false;
+    copyDevice = nullptr;
+    if ((!error) && (device->write(capture) != capture.size()))
+        error = true;
+    capture.clear();
+    return !error;
+}
+
+bool jsonStreamReader::hasError() const
+{
+    return error;
+}
+
+qint64 jsonStreamReader::bytesRead() const
+{
+    return totalRead;
+}
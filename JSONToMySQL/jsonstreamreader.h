@@ -0,0 +1,70 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#ifndef JSONSTREAMREADER_H
+#define JSONSTREAMREADER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QJsonValue>
+#include <QIODevice>
+
+//Reads a JSON file incrementally. Only the value being read is kept in memory
+//so large arrays can be walked one item at a time.
+class jsonStreamReader
+{
+public:
+    jsonStreamReader();
+    bool open(QString fileName);
+    bool rewind();
+    bool seek(qint64 pos);
+    void close();
+    bool beginObject();
+    bool nextKey(QString &key);
+    bool beginArray();
+    bool nextElement();
+    bool isArray();
+    QJsonValue readValue();
+    void skipValue();
+    bool copyValue(QIODevice *device);
+    bool hasError() const;
+    qint64 bytesRead() const;
+private:
+    bool fillBuffer();
+    bool peekChar(char &c);
+    bool getChar(char &c);
+    bool expect(char c);
+    void skipWhiteSpace();
+    void scanValue();
+    void scanString();
+    QFile file;
+    QByteArray buffer;
+    int bufferPos;
+    bool capturing;
+    QByteArray capture;
+    QIODevice *copyDevice; //Receives the captured text as it is read in copyValue
+    bool error;
+    qint64 totalRead;
+    QList<bool> firstItem; //Whether the next key or element is the first one of its object or array
+};
+
+#endif // JSONSTREAMREADER_H
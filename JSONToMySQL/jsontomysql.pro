@@ -17,9 +17,33 @@ TEMPLATE = app
 unix:INCLUDEPATH += ../3rdparty
 
 SOURCES += main.cpp \
+    checkpointfile.cpp \
+    filequeue.cpp \
+    importoutput.cpp \
+    importplan.cpp \
+    importstats.cpp \
+    importworker.cpp \
+    insertbuffer.cpp \
+    insertrules.cpp \
     insertvalues.cpp \
+    jsonstreamreader.cpp \
+    recordtree.cpp \
+    schemavalidator.cpp \
+    spooldirectory.cpp \
     mainclass.cpp
 
 HEADERS += \
+    checkpointfile.h \
+    filequeue.h \
+    importoutput.h \
+    importplan.h \
+    importstats.h \
+    importworker.h \
+    insertbuffer.h \
+    insertrules.h \
     insertvalues.h \
+    jsonstreamreader.h \
+    recordtree.h \
+    schemavalidator.h \
+    spooldirectory.h \
     mainclass.h
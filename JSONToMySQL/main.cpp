@@ -21,7 +21,14 @@ License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3
 #include <QCoreApplication>
 #include <tclap/CmdLine.h>
 #include "mainclass.h"
+#include <QDir>
 #include <QDebug>
+#ifdef Q_OS_UNIX
+#include <QSocketNotifier>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 void log(QString message)
 {
@@ -30,6 +37,39 @@ void log(QString message)
     printf("%s",temp.toLocal8Bit().data());
 }
 
+#ifdef Q_OS_UNIX
+//SIGTERM and SIGINT stop the daemon. The handler only writes to a socket that is read in the event loop
+static int stopSocket[2];
+
+static void stopHandler(int)
+{
+    char stop = 1;
+    ssize_t res = ::write(stopSocket[0], &stop, sizeof(stop));
+    Q_UNUSED(res);
+}
+
+static void installStopHandler(QCoreApplication *app, mainClass *task)
+{
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, stopSocket) != 0)
+    {
+        log("Warning: Cannot install the stop signal handler");
+        return;
+    }
+    QSocketNotifier *notifier = new QSocketNotifier(stopSocket[1], QSocketNotifier::Read, app);
+    QObject::connect(notifier, &QSocketNotifier::activated, [notifier, task]()
+    {
+        notifier->setEnabled(false);
+        task->stop();
+    });
+    struct sigaction action;
+    action.sa_handler = stopHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+}
+#endif
+
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
@@ -45,19 +85,32 @@ int main(int argc, char *argv[])
 
     TCLAP::CmdLine cmd(title.toUtf8().constData(), ' ', "2.0");
 
-    TCLAP::ValueArg<std::string> jsonArg("j","json","Input JSON File",true,"","string");
+    TCLAP::ValueArg<std::string> jsonArg("j","json","Input JSON File",false,"","string");
+    TCLAP::ValueArg<std::string> dirArg("d","directory","Batch mode: Import all the JSON files in a directory",false,"","string");
+    TCLAP::ValueArg<std::string> listArg("l","filelist","Batch mode: Import the JSON files listed (one per line) in a text file",false,"","string");
+    TCLAP::ValueArg<std::string> spoolArg("D","spooldir","Daemon mode: Watch a directory and import each JSON file that lands in it",false,"","string");
+    TCLAP::ValueArg<std::string> errorDirArg("e","errordir","Batch mode: Directory to store the machine readable error log of each file. Default ./errorLogs",false,"./errorLogs","string");
     TCLAP::ValueArg<std::string> manifestArg("m","manifest","Input manifest XML file",true,"","string");
     TCLAP::ValueArg<std::string> hostArg("H","host","MySQL Host. Default: localhost",false,"localhost","string");
     TCLAP::ValueArg<std::string> portArg("P","port","MySQL port. Default: 3306",false,"3306","string");
-    TCLAP::ValueArg<std::string> userArg("u","user","MySQL User",true,"","string");
-    TCLAP::ValueArg<std::string> passArg("p","password","MySQL Password",true,"","string");
-    TCLAP::ValueArg<std::string> schemaArg("s","schema","MySQL Schema",true,"","string");
+    TCLAP::ValueArg<std::string> userArg("u","user","MySQL User. Not needed with -V",false,"","string");
+    TCLAP::ValueArg<std::string> passArg("p","password","MySQL Password. Not needed with -V",false,"","string");
+    TCLAP::ValueArg<std::string> schemaArg("s","schema","MySQL Schema. Not needed with -V",false,"","string");
+    TCLAP::ValueArg<std::string> createArg("c","create","Validation: Input create XML file",false,"","string");
+    TCLAP::ValueArg<std::string> insertArg("x","insert","Validation: Input insert XML file",false,"","string");
     TCLAP::ValueArg<std::string> outputArg("o","output","Output Log file",false,"./output.csv","string");    
     TCLAP::ValueArg<std::string> JSArg("J","javascript","Custom Before Insert JavaScript",false,"","string");
     TCLAP::SwitchArg overwriteSwitch("w","overwrite","Overwrite the log file", cmd, false);
+    TCLAP::SwitchArg validateSwitch("V","validate","Only check the files against the create and insert XML files without connecting to MySQL", cmd, false);
+    TCLAP::SwitchArg checkpointSwitch("C","checkpoint","Import each top-level repeat item in its own transaction and resume from a checkpoint file", cmd, false);
     TCLAP::SwitchArg oputSQLSwitch("S","outputSQL","Output each insert SQL to ./inputfile.json.sql", cmd, false);
     TCLAP::ValueArg<std::string> mapDirArg("M","mapoutputdir","Map output directory",false,"./recordMaps","string");
     TCLAP::ValueArg<std::string> uuIdsArg("U","uuidsfile","UUIDs output file",false,"./uuids.log","string");
+    TCLAP::ValueArg<std::string> batchSizeArg("b","batchsize","Number of rows sent to MySQL in each multi-row INSERT. Default: 500",false,"500","string");
+    TCLAP::ValueArg<std::string> bulkArg("B","bulkthreshold","Tables receiving at least this number of rows are loaded with LOAD DATA LOCAL INFILE. Default: 0 (disabled)",false,"0","string");
+    TCLAP::ValueArg<std::string> workersArg("t","threads","Batch mode: Number of files imported in parallel. Each uses its own MySQL connection. Default: 1",false,"1","string");
+    TCLAP::ValueArg<std::string> rulesArg("R","rules","XML file with declarative insert rules (remap, set and drop columns) applied without JavaScript",false,"","string");
+    TCLAP::ValueArg<std::string> statsArg("T","statsfile","Write the time and rows per phase and table to this JSON file",false,"","string");
     TCLAP::ValueArg<std::string> outTypeArg("O","outputtype","OutputType: (h)uman readable or (m)achine readble",false,"m","string");
 
     TCLAP::UnlabeledMultiArg<std::string> suppFiles("supportFile", "support files", false, "string");
@@ -68,17 +121,28 @@ int main(int argc, char *argv[])
     //TCLAP::SwitchArg extractSwitch("e","extract","Extract number from primary key", cmd, false);
 
     cmd.add(jsonArg);
+    cmd.add(dirArg);
+    cmd.add(listArg);
+    cmd.add(spoolArg);
+    cmd.add(errorDirArg);
     cmd.add(manifestArg);
     cmd.add(hostArg);
     cmd.add(portArg);
     cmd.add(userArg);
     cmd.add(passArg);
     cmd.add(schemaArg);
+    cmd.add(createArg);
+    cmd.add(insertArg);
     cmd.add(outputArg);    
     cmd.add(mapDirArg);
     cmd.add(outTypeArg);
     cmd.add(uuIdsArg);
     cmd.add(JSArg);
+    cmd.add(rulesArg);
+    cmd.add(statsArg);
+    cmd.add(batchSizeArg);
+    cmd.add(bulkArg);
+    cmd.add(workersArg);
     cmd.add(suppFiles);
 
     //Parsing the command lines
@@ -102,23 +166,118 @@ int main(int argc, char *argv[])
     //Getting the variables from the command
     bool overwrite = overwriteSwitch.getValue();
     QString json = QString::fromUtf8(jsonArg.getValue().c_str());
+    QString jsonDir = QString::fromUtf8(dirArg.getValue().c_str());
+    QString jsonList = QString::fromUtf8(listArg.getValue().c_str());
+    QString spoolDir = QString::fromUtf8(spoolArg.getValue().c_str());
+    QString errorDir = QString::fromUtf8(errorDirArg.getValue().c_str());
     QString manifest = QString::fromUtf8(manifestArg.getValue().c_str());
     QString host = QString::fromUtf8(hostArg.getValue().c_str());
     QString port = QString::fromUtf8(portArg.getValue().c_str());
     QString user = QString::fromUtf8(userArg.getValue().c_str());
     QString password = QString::fromUtf8(passArg.getValue().c_str());
     QString schema = QString::fromUtf8(schemaArg.getValue().c_str());
+    QString createXML = QString::fromUtf8(createArg.getValue().c_str());
+    QString insertXML = QString::fromUtf8(insertArg.getValue().c_str());
+    bool validate = validateSwitch.getValue();
     QString output = QString::fromUtf8(outputArg.getValue().c_str());    
     QString javaScript = QString::fromUtf8(JSArg.getValue().c_str());
     QString mapDirectory = QString::fromUtf8(mapDirArg.getValue().c_str());
     QString outputType = QString::fromUtf8(outTypeArg.getValue().c_str());
     QString uuidsFile = QString::fromUtf8(uuIdsArg.getValue().c_str());
+    QString rulesFile = QString::fromUtf8(rulesArg.getValue().c_str());
+    QString statsFile = QString::fromUtf8(statsArg.getValue().c_str());
+    bool ok;
+    int batchSize = QString::fromUtf8(batchSizeArg.getValue().c_str()).toInt(&ok);
+    if (!ok)
+        batchSize = 500;
+    int bulkThreshold = QString::fromUtf8(bulkArg.getValue().c_str()).toInt(&ok);
+    if (!ok)
+        bulkThreshold = 0;
+    int numWorkers = QString::fromUtf8(workersArg.getValue().c_str()).toInt(&ok);
+    if (!ok)
+        numWorkers = 1;
+
+    if (validate)
+    {
+        if ((createXML == "") || (insertXML == ""))
+        {
+            log("The validation needs the create XML (-c) and the insert XML (-x) files");
+            return 1;
+        }
+    }
+    else
+    {
+        if ((user == "") || (schema == ""))
+        {
+            log("You need to indicate the MySQL user (-u), password (-p) and schema (-s)");
+            return 1;
+        }
+    }
+
+    int inputs = 0;
+    if (json != "")
+        inputs++;
+    if (jsonDir != "")
+        inputs++;
+    if (jsonList != "")
+        inputs++;
+    if (spoolDir != "")
+        inputs++;
+    if (inputs != 1)
+    {
+        log("You need to indicate one JSON file (-j), a directory (-d), a file list (-l) or a spool directory (-D)");
+        return 1;
+    }
+
+    QStringList jsonFiles;
+    bool batchMode = false;
+    if (json != "")
+        jsonFiles.append(json);
+    if (jsonDir != "")
+    {
+        QDir dir(jsonDir);
+        if (!dir.exists())
+        {
+            log("Directory \"" + jsonDir + "\" does not exist.");
+            return 1;
+        }
+        QStringList filters;
+        filters << "*.json";
+        QFileInfoList files = dir.entryInfoList(filters, QDir::Files, QDir::Name);
+        for (int i = 0; i < files.count(); i++)
+            jsonFiles.append(files[i].absoluteFilePath());
+        batchMode = true;
+    }
+    if (jsonList != "")
+    {
+        QFile listFile(jsonList);
+        if (!listFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            log("Cannot open file list \"" + jsonList + "\".");
+            return 1;
+        }
+        QTextStream in(&listFile);
+        while (!in.atEnd())
+        {
+            QString file = in.readLine().trimmed();
+            if (file != "")
+                jsonFiles.append(file);
+        }
+        listFile.close();
+        batchMode = true;
+    }
+    if (spoolDir != "")
+        batchMode = true;
 
     mainClass *task = new mainClass(&app);
 
-    task->setParameters(overwrite,json,manifest,host,port,user,password,schema,output,javaScript,oputSQLSwitch.getValue(),mapDirectory,outputType, uuidsFile, supportFiles);
+    task->setParameters(overwrite,jsonFiles,batchMode,errorDir,manifest,host,port,user,password,schema,output,javaScript,oputSQLSwitch.getValue(),mapDirectory,outputType, uuidsFile, supportFiles, batchSize, numWorkers, rulesFile, bulkThreshold, statsFile, spoolDir, checkpointSwitch.getValue(), validate, createXML, insertXML);
 
     QObject::connect(task, SIGNAL(finished()), &app, SLOT(quit()));
+#ifdef Q_OS_UNIX
+    if (spoolDir != "")
+        installStopHandler(&app, task);
+#endif
 
     QTimer::singleShot(0, task, SLOT(run()));
 
@@ -22,63 +22,27 @@ License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3
 #define MAINCLASS_H
 
 #include <QObject>
-//#include <qjson-qt5/parser.h>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QFile>
 #include <QTextStream>
 #include <QStringList>
 #include <QFileInfo>
-#include <QVariantMap>
-#include <QVariantList>
-#include <QVariant>
-#include <QtXml>
+#include <QDir>
 #include <QList>
-#include <QSqlQuery>
 #include <QJSEngine>
 #include <QJSValue>
 #include <QJSValueList>
+#include <QElapsedTimer>
 #include "insertvalues.h"
-#include <QDomDocument>
-#include <QDomElement>
-#include <QDomNodeList>
-
-struct tblIndexDef
-{
-    QString table;
-    int index;
-};
-typedef tblIndexDef TtblIndexDef;
-
-struct OSMFileDef
-{
-    QString fileName;
-    QString baseName;
-};
-typedef OSMFileDef TOSMFileDef;
-
-struct fieldDef
-{
-  QString name;
-  QString xmlCode;
-  QString value;
-  bool key;
-  bool multiSelect;
-  QString multiSelectTable;
-  QString uuid;
-  QString type;
-  QString size;
-  QString decSize;
-  QString ODKType;
-};
-typedef fieldDef TfieldDef;
-
-struct tableKey
-{
-    int index;
-    QList< TfieldDef> keys;
-};
-typedef tableKey TtableKey;
+#include "importplan.h"
+#include "importworker.h"
+#include "insertrules.h"
+#include "importstats.h"
+#include "filequeue.h"
+#include "importoutput.h"
+#include "spooldirectory.h"
+#include "schemavalidator.h"
 
 class mainClass : public QObject
 {
@@ -91,59 +55,33 @@ signals:
     void finishedWithError(int error);
 public slots:
     void run();
-    void setParameters(bool voverwrite, QString vjson, QString vmanifest, QString vhost, QString vport, QString vuser, QString vpassword, QString vschema, QString voutput, QString vjavaScript, bool voputSQLSwitch, QString mapDirectory, QString outputType, QString uuidsFile, QStringList supportFiles);
+    void stop();
+    void setParameters(bool voverwrite, QStringList vjsonFiles, bool vbatchMode, QString verrorOutputDir, QString vmanifest, QString vhost, QString vport, QString vuser, QString vpassword, QString vschema, QString voutput, QString vjavaScript, bool voputSQLSwitch, QString mapDirectory, QString outputType, QString uuidsFile, QStringList supportFiles, int batchSize, int numWorkers, QString rulesFile, int bulkThreshold, QString statsFile, QString spoolDir, bool checkpoint, bool validate, QString createXML, QString insertXML);
+private slots:
+    void workerFinished();
 private:
-    void logLoopError(QString errorMessage, QString table, QString loopItem, QString execSQL);
-    void processLoop(QJsonObject jsonData, QString loopTable, QString loopXMLRoot, QStringList loopItems, QList< TfieldDef> fields, QList< TfieldDef> parentkeys, QSqlDatabase db);
-    QString fixField(QString source);
-    void logOSMError(QString errorMessage, QString table, int nodeIndex, QString execSQL);
-    void insertOSMData(QString OSMField, QDomElement node, int nodeIndex, QDomNodeList tags, QList< TfieldDef> parentkeys, QSqlDatabase db);
-    void processOSM(QString OSMField, QString OSMFile, QList< TfieldDef> parentkeys, QSqlDatabase db);
-    int getLastIndex(QString table);
     void log(QString message);
-    QString getXMLCodeFromField(QList< TfieldDef> fields, QString field);
-    void logError(QString errorMessage, QString table, int rowNumber, QString execSQL);
-    void logErrorMSel(QString errorMessage, QString table, int rowNumber, QString execSQL);
-    QString fixString(QString source);
-    QList<TfieldDef > createSQL(QSqlDatabase db, QVariantMap jsonData, QString table, QList< TfieldDef> fields, QList< TfieldDef> parentkeys, QVariantMap jsonData2, bool mTable);
-    void debugKeys(QString table, QList< TfieldDef> keys);
-    void debugMap(QVariantMap jsonData);
-    int procTable(QSqlDatabase db, QVariantMap jsonData, QDomNode table, QList< TfieldDef> parentkeys);
-    int procTable2(QSqlDatabase db, QJsonObject jsonData, QDomNode table, QList< TfieldDef> parentkeys);
-    int processFile(QSqlDatabase db, QString json, QString manifest, QStringList procList);
-    int processFile2(QSqlDatabase db, QString json, QString manifest);
-    void storeRecord(QStringList parentUUIDS, QString recordUUID);
-    void storeRecord(QString parentUUID, QString recordUUID);
-    void findElementsWithAttribute(const QDomElement& elem, const QString& attr, const QString& attvalue, QList<QDomElement> &foundElements);
-
-    QJSValue beforeInsertFunction;
-    bool callBeforeInsert;
-    QList <TtblIndexDef > lstTblIndex;
-
-    bool SQLError;
-    QString SQLErrorNumber;
-    QString fileID;
-    QString mainTable;
-
-    //Huma logging
-    QFile logFile;
-    QTextStream logStream;
-    //Machine loggin
-    QDomDocument xmlLog;
-    QDomElement eErrors;
-
-    bool outSQL;
-    QFile sqlFile;
-    QTextStream sqlStream;
-    QDomDocument recordMap;
-    QDomElement recordMapRoot;
-    QStringList UUIDList;
+    int loadManifest();
+    void finish();
 
+    importPlan plan;
+    insertRules rules;
+    schemaValidator validator;
     QJSEngine JSEngine;
+    fileQueue queue;
+    importOutput importOut;
+    spoolDirectory spool;
+    QList<importWorker *> importWorkers;
+    int runningWorkers;
+    bool stopping;
+    importStats stats;
+    QElapsedTimer wallTime;
 
     //Run parameters
     bool overwrite;
-    QString json;
+    QStringList jsonFiles;
+    bool batchMode;
+    QString errorOutputDir;
     QString manifest;
     QString host;
     QString port;
@@ -153,10 +91,21 @@ private:
     QString output;
 
     QString javaScript;
+    bool outSQL;
+    int batchSize;
+    int bulkThreshold;
+    int numWorkers;
+    QString rulesFile;
+    QString statsFile;
+    QString spoolDir;
+    bool checkpoint;
+    bool validate;
+    QString createXML;
+    QString insertXML;
     QString mapOutputDir;
     QString outputType;
     QString UUIDsFile;
-    QList<OSMFileDef> OSMFiles;
+    QList<TOSMFileDef> OSMFiles;
 };
 
 #endif // MAINCLASS_H
@@ -0,0 +1,108 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#include "recordtree.h"
+
+recordTree::recordTree()
+{
+
+}
+
+void recordTree::clear()
+{
+    records.clear();
+    roots.clear();
+    index.clear();
+}
+
+//Adds a record in the root of the map
+bool recordTree::addRecord(QString table, QString uuid)
+{
+    TmapRecord record;
+    record.table = table;
+    record.uuid = uuid;
+    roots.append(records.count());
+    index.insert(uuid, records.count());
+    records.append(record);
+    return true;
+}
+
+//Adds a record under its parent. If the parent is not found means that his insert
+//did not entered the database thus the record is not added
+bool recordTree::addRecord(QString parentUUID, QString table, QString uuid)
+{
+    int parent = index.value(parentUUID, -1);
+    if (parent == -1)
+        return false;
+    TmapRecord record;
+    record.table = table;
+    record.uuid = uuid;
+    records[parent].children.append(records.count());
+    index.insert(uuid, records.count());
+    records.append(record);
+    return true;
+}
+
+int recordTree::count() const
+{
+    return records.count();
+}
+
+//Removes the records added after the map had the given number of records
+void recordTree::truncate(int count)
+{
+    while (records.count() > count)
+    {
+        index.remove(records.last().uuid);
+        records.removeLast();
+    }
+    //Records are always appended so the removed ones are at the end of each list
+    while ((!roots.isEmpty()) && (roots.last() >= count))
+        roots.removeLast();
+    for (int pos = 0; pos < records.count(); pos++)
+    {
+        while ((!records[pos].children.isEmpty()) && (records[pos].children.last() >= count))
+            records[pos].children.removeLast();
+    }
+}
+
+void recordTree::appendRecord(QDomDocument &document, QDomElement &parent, int index) const
+{
+    QDomElement aRecord;
+    aRecord = document.createElement("record");
+    aRecord.setAttribute("table",records[index].table);
+    aRecord.setAttribute("uuid",records[index].uuid);
+    parent.appendChild(aRecord);
+    for (int pos = 0; pos < records[index].children.count(); pos++)
+        appendRecord(document, aRecord, records[index].children[pos]);
+}
+
+//Creates the XML record map
+QDomDocument recordTree::toDocument() const
+{
+    QDomDocument recordMap("ODKRecordMapFile");
+    QDomElement recordMapRoot;
+    recordMapRoot = recordMap.createElement("ODKRecordMapXML");
+    recordMapRoot.setAttribute("version", "1.0");
+    recordMap.appendChild(recordMapRoot);
+    for (int pos = 0; pos < roots.count(); pos++)
+        appendRecord(recordMap, recordMapRoot, roots[pos]);
+    return recordMap;
+}
@@ -0,0 +1,57 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#ifndef RECORDTREE_H
+#define RECORDTREE_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QDomDocument>
+#include <QDomElement>
+
+struct mapRecord
+{
+    QString table;
+    QString uuid;
+    QList<int> children; //Index of the child records
+};
+typedef mapRecord TmapRecord;
+
+//The record map of a submission. Records are indexed by UUID so a child finds
+//its parent without walking the tree. The XML is only created at the end.
+class recordTree
+{
+public:
+    recordTree();
+    void clear();
+    bool addRecord(QString table, QString uuid);
+    bool addRecord(QString parentUUID, QString table, QString uuid);
+    int count() const;
+    void truncate(int count);
+    QDomDocument toDocument() const;
+private:
+    void appendRecord(QDomDocument &document, QDomElement &parent, int index) const;
+    QList<TmapRecord> records;
+    QList<int> roots;
+    QHash<QString, int> index;
+};
+
+#endif // RECORDTREE_H
@@ -0,0 +1,248 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#include "schemavalidator.h"
+#include <QFile>
+#include <QDomDocument>
+#include <QDomElement>
+#include <QRegularExpression>
+#include <QDate>
+
+schemaValidator::schemaValidator()
+{
+
+}
+
+void schemaValidator::log(QString message)
+{
+    QString temp;
+    temp = message + "\n";
+    printf("%s",temp.toLocal8Bit().data());
+}
+
+//Reads the columns of all the tables (and their child tables)
+void schemaValidator::loadTables(QDomNode node)
+{
+    while (!node.isNull())
+    {
+        QDomElement eTable = node.toElement();
+        if (eTable.tagName() == "table")
+        {
+            QHash<QString, TcolumnDef> &columns = tables[eTable.attribute("name","").toLower()];
+            QDomNode child = node.firstChild();
+            while (!child.isNull())
+            {
+                QDomElement eField = child.toElement();
+                if (eField.tagName() == "field")
+                {
+                    TcolumnDef column;
+                    column.type = eField.attribute("type","varchar").toLower();
+                    column.size = eField.attribute("size","0").toInt();
+                    column.decSize = eField.attribute("decsize","0").toInt();
+                    column.key = (eField.attribute("key","false") == "true");
+                    if (eField.attribute("rlookup","false") == "true")
+                        column.lookupTable = eField.attribute("rtable","").toLower();
+                    columns.insert(eField.attribute("name","").toLower(), column);
+                }
+                child = child.nextSibling();
+            }
+            loadTables(node.firstChild());
+        }
+        node = node.nextSibling();
+    }
+}
+
+//Loads the create XML and the codes of the lookup tables from the insert XML. Returns 0 if both are loaded
+int schemaValidator::load(QString createXML, QString insertXML)
+{
+    QDomDocument createDoc("createXML");
+    QFile createFile(createXML);
+    if (!createFile.open(QIODevice::ReadOnly))
+    {
+        log("Cannot open create XML file");
+        return 1;
+    }
+    if (!createDoc.setContent(&createFile))
+    {
+        log("Cannot parse create XML file");
+        createFile.close();
+        return 1;
+    }
+    createFile.close();
+    QDomNode section = createDoc.documentElement().firstChild();
+    while (!section.isNull())
+    {
+        loadTables(section.firstChild());
+        section = section.nextSibling();
+    }
+
+    QDomDocument insertDoc("insertXML");
+    QFile insertFile(insertXML);
+    if (!insertFile.open(QIODevice::ReadOnly))
+    {
+        log("Cannot open insert XML file");
+        return 1;
+    }
+    if (!insertDoc.setContent(&insertFile))
+    {
+        log("Cannot parse insert XML file");
+        insertFile.close();
+        return 1;
+    }
+    insertFile.close();
+    QDomNode lookupNode = insertDoc.documentElement().firstChild();
+    while (!lookupNode.isNull())
+    {
+        QSet<QString> &codes = lookups[lookupNode.toElement().attribute("name","").toLower()];
+        QDomNode valueNode = lookupNode.firstChild();
+        while (!valueNode.isNull())
+        {
+            codes.insert(valueNode.toElement().attribute("code",""));
+            valueNode = valueNode.nextSibling();
+        }
+        lookupNode = lookupNode.nextSibling();
+    }
+    return 0;
+}
+
+//Returns whether a value can be inserted in a column. If not, error has the reason
+bool schemaValidator::checkValue(const QString &table, const QString &column, const QVariant &value, QString &error) const
+{
+    static const QRegularExpression intExp("^[+-]?\\d+$");
+    static const QRegularExpression decimalExp("^[+-]?(\\d*)(\\.(\\d*))?$");
+    static const QRegularExpression dateExp("^(\\d{4})-(\\d{1,2})-(\\d{1,2})([ T](\\d{1,2}):(\\d{1,2})(:(\\d{1,2})(\\.\\d+)?)?)?$");
+    static const QRegularExpression timeExp("^(\\d{1,3}):(\\d{1,2})(:(\\d{1,2})(\\.\\d+)?)?$");
+
+    QHash<QString, QHash<QString, TcolumnDef> >::const_iterator tableDef = tables.constFind(table.toLower());
+    if (tableDef == tables.constEnd())
+    {
+        error = "Table '" + table + "' doesn't exist";
+        return false;
+    }
+    QHash<QString, TcolumnDef>::const_iterator columnDef = tableDef.value().constFind(column.toLower());
+    if (columnDef == tableDef.value().constEnd())
+    {
+        error = "Unknown column '" + column + "' in 'field list'";
+        return false;
+    }
+    const TcolumnDef &def = columnDef.value();
+    if (value.isNull())
+    {
+        if (def.key)
+        {
+            error = "Column '" + column + "' cannot be null";
+            return false;
+        }
+        return true;
+    }
+    QString strValue = value.toString();
+
+    if (def.lookupTable != "")
+    {
+        QHash<QString, QSet<QString> >::const_iterator codes = lookups.constFind(def.lookupTable);
+        if ((codes != lookups.constEnd()) && (!codes.value().contains(strValue)))
+        {
+            error = "Cannot add or update a child row: a foreign key constraint fails. The value '" + strValue + "' of column '" + column + "' is not in the lookup table '" + def.lookupTable + "'";
+            return false;
+        }
+    }
+
+    if ((def.type == "varchar") || (def.type == "char"))
+    {
+        if ((def.size > 0) && (strValue.length() > def.size))
+        {
+            error = "Data too long for column '" + column + "' at row 1";
+            return false;
+        }
+        return true;
+    }
+    if (def.type == "text")
+    {
+        if (strValue.toUtf8().size() > 65535)
+        {
+            error = "Data too long for column '" + column + "' at row 1";
+            return false;
+        }
+        return true;
+    }
+    if ((def.type == "int") || (def.type == "integer") || (def.type == "bigint"))
+    {
+        QString trimmed = strValue.trimmed();
+        bool ok = intExp.match(trimmed).hasMatch();
+        if (!ok)
+        {
+            error = "Incorrect integer value: '" + strValue + "' for column '" + column + "' at row 1";
+            return false;
+        }
+        qlonglong number = trimmed.toLongLong(&ok);
+        if ((!ok) || ((def.type != "bigint") && ((number > 2147483647LL) || (number < -2147483648LL))))
+        {
+            error = "Out of range value for column '" + column + "' at row 1";
+            return false;
+        }
+        return true;
+    }
+    if (def.type == "decimal")
+    {
+        QRegularExpressionMatch match = decimalExp.match(strValue.trimmed());
+        if ((!match.hasMatch()) || ((match.captured(1) == "") && (match.captured(3) == "")))
+        {
+            error = "Incorrect decimal value: '" + strValue + "' for column '" + column + "' at row 1";
+            return false;
+        }
+        //Decimals beyond decsize are rounded by MySQL but the integer part must fit
+        QString integerPart = match.captured(1);
+        while (integerPart.startsWith("0"))
+            integerPart = integerPart.mid(1);
+        if ((def.size > 0) && (integerPart.length() > def.size - def.decSize))
+        {
+            error = "Out of range value for column '" + column + "' at row 1";
+            return false;
+        }
+        return true;
+    }
+    if ((def.type == "date") || (def.type == "datetime"))
+    {
+        QRegularExpressionMatch match = dateExp.match(strValue.trimmed());
+        bool ok = match.hasMatch();
+        if (ok)
+            ok = QDate(match.captured(1).toInt(), match.captured(2).toInt(), match.captured(3).toInt()).isValid();
+        if (ok && (match.captured(4) != ""))
+            ok = (match.captured(5).toInt() < 24) && (match.captured(6).toInt() < 60) && (match.captured(8).toInt() < 60);
+        if (!ok)
+        {
+            error = "Incorrect " + def.type + " value: '" + strValue + "' for column '" + column + "' at row 1";
+            return false;
+        }
+        return true;
+    }
+    if (def.type == "time")
+    {
+        QRegularExpressionMatch match = timeExp.match(strValue.trimmed());
+        if ((!match.hasMatch()) || (match.captured(2).toInt() >= 60) || (match.captured(4).toInt() >= 60))
+        {
+            error = "Incorrect time value: '" + strValue + "' for column '" + column + "' at row 1";
+            return false;
+        }
+        return true;
+    }
+    //Other types (e.g. geometry or double) are left to MySQL
+    return true;
+}
@@ -0,0 +1,56 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#ifndef SCHEMAVALIDATOR_H
+#define SCHEMAVALIDATOR_H
+
+#include <QString>
+#include <QVariant>
+#include <QHash>
+#include <QSet>
+#include <QDomNode>
+
+struct columnDef
+{
+    QString type;
+    int size;
+    int decSize;
+    bool key;
+    QString lookupTable; //Lookup table of the column. Empty if the column is not a lookup
+};
+typedef columnDef TcolumnDef;
+
+//Checks values against the schema described by the create and insert XML files
+//generated by JXFormToMySQL without connecting to MySQL. Errors are reported with
+//the same text MySQL would use in strict mode.
+class schemaValidator
+{
+public:
+    schemaValidator();
+    int load(QString createXML, QString insertXML);
+    bool checkValue(const QString &table, const QString &column, const QVariant &value, QString &error) const;
+private:
+    void log(QString message);
+    void loadTables(QDomNode node);
+    QHash<QString, QHash<QString, TcolumnDef> > tables;
+    QHash<QString, QSet<QString> > lookups;
+};
+
+#endif // SCHEMAVALIDATOR_H
@@ -0,0 +1,165 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#include "spooldirectory.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QFile>
+
+//Directory events can be lost (e.g. when the watch is added) so the spool is also scanned every few seconds
+#define RESCAN_INTERVAL 5000
+//Milliseconds a file must keep the same size and time before it is claimed
+#define STABLE_TIME 2000
+
+spoolDirectory::spoolDirectory(QObject *parent) : QObject(parent)
+{
+    queue = nullptr;
+    output = nullptr;
+    connect(&watcher, SIGNAL(directoryChanged(QString)), this, SLOT(scan()));
+    connect(&rescanTimer, SIGNAL(timeout()), this, SLOT(scan()));
+    stableTimer.setSingleShot(true);
+    connect(&stableTimer, SIGNAL(timeout()), this, SLOT(scan()));
+}
+
+void spoolDirectory::log(QString message)
+{
+    QString temp;
+    temp = message + "\n";
+    printf("%s",temp.toLocal8Bit().data());
+}
+
+//Creates the work, done and error subdirectories. Returns 0 if the spool is ready
+int spoolDirectory::open(QString spoolDir)
+{
+    QDir dir(spoolDir);
+    if (!dir.exists())
+    {
+        log("Spool directory \"" + spoolDir + "\" does not exist.");
+        return 1;
+    }
+    this->spoolDir = dir.absolutePath();
+    workDir = dir.absoluteFilePath("work");
+    QStringList subDirs;
+    subDirs << "work" << "done" << "error";
+    for (int pos = 0; pos < subDirs.count(); pos++)
+    {
+        if (!dir.mkpath(subDirs[pos]))
+        {
+            log("Cannot create directory \"" + dir.absoluteFilePath(subDirs[pos]) + "\".");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void spoolDirectory::setQueue(fileQueue *queue)
+{
+    this->queue = queue;
+}
+
+void spoolDirectory::setOutput(importOutput *output)
+{
+    this->output = output;
+}
+
+QString spoolDirectory::doneDir()
+{
+    return QDir(spoolDir).absoluteFilePath("done");
+}
+
+QString spoolDirectory::errorDir()
+{
+    return QDir(spoolDir).absoluteFilePath("error");
+}
+
+//Queues the files left by a previous run and starts watching the spool
+void spoolDirectory::start()
+{
+    QStringList filters;
+    filters << "*.json";
+    QFileInfoList files = QDir(workDir).entryInfoList(filters, QDir::Files, QDir::Name);
+    for (int pos = 0; pos < files.count(); pos++)
+    {
+        //The file was committed but the process stopped before it was moved to done
+        if ((output != nullptr) && (output->isCommitted(files[pos].absoluteFilePath())))
+        {
+            log("Completing " + files[pos].fileName() + ". It was already imported");
+            output->writeCommitted(files[pos].absoluteFilePath());
+            continue;
+        }
+        log("Resuming " + files[pos].fileName());
+        queue->add(files[pos].absoluteFilePath());
+    }
+    watcher.addPath(spoolDir);
+    rescanTimer.start(RESCAN_INTERVAL);
+    scan();
+}
+
+void spoolDirectory::stop()
+{
+    rescanTimer.stop();
+    stableTimer.stop();
+    watcher.removePath(spoolDir);
+}
+
+//Claims the new files. A file still being written changes its size or time between scans so it
+//is only claimed when they stay the same for STABLE_TIME. The rename fails if another process
+//claimed the file first
+void spoolDirectory::scan()
+{
+    QStringList filters;
+    filters << "*.json";
+    QFileInfoList files = QDir(spoolDir).entryInfoList(filters, QDir::Files, QDir::Time | QDir::Reversed);
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    QHash<QString, fileState> stillPending;
+    bool waiting = false;
+    for (int pos = 0; pos < files.count(); pos++)
+    {
+        QString fileName = files[pos].fileName();
+        fileState state;
+        state.size = files[pos].size();
+        state.modified = files[pos].lastModified();
+        state.seen = now;
+        if (pending.contains(fileName))
+        {
+            const fileState &previous = pending[fileName];
+            if ((previous.size == state.size) && (previous.modified == state.modified))
+                state.seen = previous.seen;
+        }
+        if (state.seen.msecsTo(now) < STABLE_TIME)
+        {
+            stillPending.insert(fileName, state);
+            waiting = true;
+            continue;
+        }
+        QString workFile = workDir + QDir::separator() + fileName;
+        if (QFile::exists(workFile))
+        {
+            stillPending.insert(fileName, state);
+            continue; //A file with the same name is being imported. Claim it later
+        }
+        if (QFile::rename(files[pos].absoluteFilePath(), workFile))
+            queue->add(workFile);
+    }
+    pending = stillPending;
+    //Look again as soon as the files waiting can be claimed instead of at the next rescan
+    if ((waiting) && (!stableTimer.isActive()))
+        stableTimer.start(STABLE_TIME);
+}
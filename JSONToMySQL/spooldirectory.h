@@ -0,0 +1,71 @@
+/*
+JSONToMySQL.
+
+Copyright (C) 2015-2017 International Livestock Research Institute.
+Author: Carlos Quiros (cquiros_at_qlands.com / c.f.quiros_at_cgiar.org)
+
+JSONToMySQL is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+JSONToMySQL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with JSONToMySQL.  If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+*/
+
+#ifndef SPOOLDIRECTORY_H
+#define SPOOLDIRECTORY_H
+
+#include <QObject>
+#include <QString>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QHash>
+#include <QDateTime>
+#include "filequeue.h"
+#include "importoutput.h"
+
+//Watches a spool directory for new JSON files and claims them for the workers.
+//A file is claimed by renaming it into the "work" subdirectory so two processes
+//never import the same file. Files left in "work" by a previous run are imported
+//again unless they have a .committed file, in which case only their outputs are written.
+//Writers should create the file with another extension and rename it to .json when complete.
+//A .json file is only claimed once its size and time have not changed for a while.
+class spoolDirectory : public QObject
+{
+    Q_OBJECT
+public:
+    explicit spoolDirectory(QObject *parent = nullptr);
+    int open(QString spoolDir);
+    void setQueue(fileQueue *queue);
+    void setOutput(importOutput *output);
+    void start();
+    void stop();
+    QString doneDir();
+    QString errorDir();
+private slots:
+    void scan();
+private:
+    void log(QString message);
+    QString spoolDir;
+    QString workDir;
+    QFileSystemWatcher watcher;
+    QTimer rescanTimer;
+    QTimer stableTimer;
+    fileQueue *queue;
+    importOutput *output;
+    struct fileState
+    {
+        qint64 size;
+        QDateTime modified;
+        QDateTime seen; //When the file was first seen with this size and time
+    };
+    QHash<QString, fileState> pending; //Files seen but not claimed yet
+};
+
+#endif // SPOOLDIRECTORY_H
@@ -20,10 +20,16 @@ unix:INCLUDEPATH += ../../3rdparty
 
 SOURCES += main.cpp \
     jsonworker.cpp \
-    listmutex.cpp \
-    mainclass.cpp
+    mainclass.cpp \
+    orderedwriter.cpp \
+    rowresolver.cpp \
+    rowwriter.cpp \
+    taskscheduler.cpp
 
 HEADERS += \
     jsonworker.h \
-    listmutex.h \
-    mainclass.h
+    mainclass.h \
+    orderedwriter.h \
+    rowresolver.h \
+    rowwriter.h \
+    taskscheduler.h
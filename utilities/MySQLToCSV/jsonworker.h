@@ -3,8 +3,10 @@
 
 #include <QThread>
 #include <QDir>
-#include "listmutex.h"
+#include <QSqlDatabase>
+#include "taskscheduler.h"
 #include "mainclass.h"
+#include "rowresolver.h"
 
 //struct taskItem
 //{
@@ -23,14 +25,18 @@ public:
     explicit JSONWorker(QObject *parent = nullptr);
     void run();
     void setTasks(QList< TtaskItem> task_list);
-    void setMutex(ListMutex *mutex);
+    void setScheduler(taskScheduler *scheduler);
+    void setLookups(const QHash<QString, QHash<QString, QString> > *lookups);
     void setName(QString name);
     void setParameters(QString host, QString port, QString user, QString pass, QString schema, QDir currDir, QString outputDirectory);
     int status;
 private:
     void log(QString message);
+    int openConnection(QSqlDatabase &db, QString connection_name);
+    int execSQLFile(QSqlDatabase &db, QString sql_file);
+    int exportQuery(QSqlDatabase &db, TtaskItem task);
     QList< TtaskItem> task_list;
-    ListMutex *mutex;
+    taskScheduler *scheduler;
     QString host;
     QString port;
     QString pass;
@@ -39,6 +45,7 @@ private:
     QDir currDir;
     QString outputDirectory;
     QString name;
+    rowResolver resolver;
 };
 
 #endif // JSONWORKER_H
@@ -75,6 +75,7 @@ int main(int argc, char *argv[])
     TCLAP::SwitchArg mselSwitch("m","includemultiselects","Include multi-select tables as files. False by default", cmd, false);
     TCLAP::SwitchArg protectSwitch("c","protect","Protect sensitive fields. False by default", cmd, false);
     TCLAP::ValueArg<std::string> numWorkers("w","workers","Number of workers. 1 by default",false,"1","string");
+    TCLAP::SwitchArg readOnlySwitch("R","readonly","Read-only export. Does not create temporary tables in the schema. False by default", cmd, false);
 
     cmd.add(hostArg);
     cmd.add(portArg);
@@ -100,6 +101,9 @@ int main(int argc, char *argv[])
     bool includeMSels;
     includeMSels = mselSwitch.getValue();
 
+    bool readOnly;
+    readOnly = readOnlySwitch.getValue();
+
 
     QString host = QString::fromUtf8(hostArg.getValue().c_str());
     QString port = QString::fromUtf8(portArg.getValue().c_str());
@@ -139,7 +143,7 @@ int main(int argc, char *argv[])
     }
 
     mainClass *task = new mainClass(&app);
-    task->setParameters(host,port,user,pass,schema,createXML,outputFile,protectSensitive,tmpDir, includeLookUps, includeMSels, encryption_key, resolve_type, workers);
+    task->setParameters(host,port,user,pass,schema,createXML,outputFile,protectSensitive,tmpDir, includeLookUps, includeMSels, encryption_key, resolve_type, workers, readOnly);
     QObject::connect(task, SIGNAL(finished()), &app, SLOT(quit()));
     QTimer::singleShot(0, task, SLOT(run()));
     app.exec();
@@ -13,8 +13,13 @@
 #include <QDebug>
 #include <QUuid>
 #include "jsonworker.h"
-#include "listmutex.h"
+#include "taskscheduler.h"
+#include "orderedwriter.h"
 #include <QSqlQuery>
+#include <QSqlRecord>
+#include <QSqlDriver>
+#include <QSqlField>
+#include <QTextStream>
 
 namespace pt = boost::property_tree;
 
@@ -31,7 +36,7 @@ void mainClass::log(QString message)
     printf("%s", temp.toUtf8().data());
 }
 
-void mainClass::setParameters(QString host, QString port, QString user, QString pass, QString schema, QString createXML, QString outputDir, bool protectSensitive, QString tempDir, bool incLookups, bool incmsels, QString encryption_key, QString resolve_type, int num_workers)
+void mainClass::setParameters(QString host, QString port, QString user, QString pass, QString schema, QString createXML, QString outputDir, bool protectSensitive, QString tempDir, bool incLookups, bool incmsels, QString encryption_key, QString resolve_type, int num_workers, bool readOnly)
 {
     this->host = host;
     this->port = port;
@@ -47,6 +52,7 @@ void mainClass::setParameters(QString host, QString port, QString user, QString
     this->incmsels = incmsels;
     this->encryption_key = encryption_key;
     this->resolve_type = resolve_type.toInt();
+    this->readOnly = readOnly;
     this->db = QSqlDatabase::addDatabase("QMYSQL","repository");
     db.setHostName(host);
     db.setPort(port.toInt());
@@ -200,9 +206,33 @@ void mainClass::loadTable(QDomNode table)
 
 }
 
+//All the tasks run in one pass. The chunk of a part starts as soon as the part is created
+//so the tables do not wait for each other between the separation and the extract
 int  mainClass::processTasks(QDir currDir)
 {
-    ListMutex *mutex = new ListMutex(this);
+    //The separation of each part goes just before its chunk. The scheduler gives the first
+    //ready task, so a worker extracts the created parts before it creates more
+    QList< TtaskItem> task_list;
+    QList<int> sep_index;
+    for (int pos = 0; pos < separate_task_list.count(); pos++)
+        sep_index.append(-1);
+    for (int pos = 0; pos < json_task_list.count(); pos++)
+    {
+        TtaskItem a_task = json_task_list[pos];
+        if (a_task.depends >= 0)
+        {
+            if (sep_index[a_task.depends] < 0)
+            {
+                sep_index[a_task.depends] = task_list.count();
+                task_list.append(separate_task_list[a_task.depends]);
+            }
+            a_task.depends = sep_index[a_task.depends];
+        }
+        task_list.append(a_task);
+    }
+
+    taskScheduler scheduler;
+    scheduler.setTasks(task_list);
 
     QList< JSONWorker*> workers;
     for (int w=1; w <= num_workers; w++)
@@ -210,17 +240,12 @@ int  mainClass::processTasks(QDir currDir)
         JSONWorker *a_worker = new JSONWorker(this);
         a_worker->setName("Worker" + QString::number(w));
         a_worker->setParameters(host, port, user, pass, schema, currDir, outputDirectory);
+        a_worker->setLookups(&lookups);
+        a_worker->setTasks(task_list);
+        a_worker->setScheduler(&scheduler);
         workers.append(a_worker);
     }
 
-    //qDebug() << "Working on separation: " + QString::number(separate_task_list.count());
-    //Work on separation
-    mutex->set_total(separate_task_list.count());
-    for (int w=0; w < workers.count(); w++)
-    {
-        workers[w]->setTasks(separate_task_list);
-        workers[w]->setMutex(mutex);
-    }
     for (int w=0; w < workers.count(); w++)
     {
         workers[w]->start();
@@ -235,105 +260,293 @@ int  mainClass::processTasks(QDir currDir)
             return -1;
     }
 
-    //qDebug() << "Working on applying updates: " + QString::number(update_task_list.count());
-    //Work on the updates
-    mutex->set_total(update_task_list.count());
-    for (int w=0; w < workers.count(); w++)
+    return 0;
+}
+
+QStringList mainClass::get_parts(int total, int parts)
+{
+    QStringList res;
+    int div = total / parts;
+    int start = 1;
+    int end = div;
+    if (parts >= total)
     {
-        workers[w]->setTasks(update_task_list);
-        workers[w]->setMutex(mutex);
+        res.append("1|" + QString::number(total));
+        return res;
     }
-    for (int w=0; w < workers.count(); w++)
+    if (parts == 1)
     {
-        workers[w]->start();
+        res.append("1|" + QString::number(total));
+        return res;
     }
-    for (int w=0; w < workers.count(); w++)
+    if (total >= 500)
     {
-        workers[w]->wait();
+        for (int pos = 1; pos < parts; pos++)
+        {
+            res.append(QString::number(start) + "|" + QString::number(end));
+            start = end + 1 ;
+            end = start + div;
+        }
+        res.append(QString::number(start) + "|" + QString::number(total));
     }
-    for (int w=0; w < workers.count(); w++)
+    else
     {
-        if (workers[w]->status != 0)
-            return -1;
+        res.append("1|" + QString::number(total));
     }
+    return res;
+}
 
-    //qDebug() << "Working on generating JSON files";
-    //Work on the JSON extract
-    mutex->set_total(json_task_list.count());
-    for (int w=0; w < workers.count(); w++)
+//The tables are split in num_workers * num_workers chunks, or more if a chunk would have more than CHUNK_ROWS rows
+int mainClass::getNumParts(int total)
+{
+    int parts = num_workers * num_workers;
+    if (total / parts >= CHUNK_ROWS)
+        parts = total / CHUNK_ROWS + 1;
+    return parts;
+}
+
+//Splits a table in ranges of its primary key with about the same number of rows. The bounds are
+//taken from one scan of the key in order so the chunks can be read with keyset pagination
+int mainClass::getKeyRanges(QString table, QStringList keys, QStringList &lows, QStringList &highs)
+{
+    lows.clear();
+    highs.clear();
+    QSqlQuery qry(db);
+    if (!qry.exec("SELECT COUNT(*) FROM " + table))
     {
-        workers[w]->setTasks(json_task_list);
-        workers[w]->setMutex(mutex);
+        log("Cannot count records in " + table);
+        return 1;
     }
-    for (int w=0; w < workers.count(); w++)
+    qry.first();
+    int tot_records = qry.value(0).toInt();
+    int num_parts = get_parts(tot_records,getNumParts(tot_records)).count();
+    if ((num_parts <= 1) || (keys.count() == 0))
     {
-        workers[w]->start();
+        lows.append("");
+        highs.append("");
+        return 0;
     }
-    for (int w=0; w < workers.count(); w++)
+    int part_size = tot_records / num_parts;
+
+    QStringList qualified_keys;
+    for (int k = 0; k < keys.count(); k++)
+        qualified_keys.append(table + "." + keys[k]);
+    QSqlQuery key_qry(db);
+    key_qry.setForwardOnly(true);
+    if (!key_qry.exec("SELECT " + qualified_keys.join(",") + " FROM " + table + " ORDER BY " + qualified_keys.join(",")))
     {
-        workers[w]->wait();
+        log("Cannot read the keys of " + table);
+        return 1;
     }
-    for (int w=0; w < workers.count(); w++)
+    QString low = "";
+    int row = 0;
+    while (key_qry.next())
     {
-        if (workers[w]->status != 0)
-            return -1;
+        row++;
+        if ((row % part_size == 0) && (highs.count() < num_parts - 1))
+        {
+            QStringList values;
+            QSqlRecord record = key_qry.record();
+            for (int k = 0; k < keys.count(); k++)
+                values.append(db.driver()->formatValue(record.field(k)));
+            QString high = "(" + values.join(",") + ")";
+            lows.append(low);
+            highs.append(high);
+            low = high;
+        }
     }
+    lows.append(low);
+    highs.append("");
+    return 0;
+}
 
-    //qDebug() << "Working on merging the final files";
-    //Work in the merging
-    mutex->set_total(merge_task_list.count());
-    for (int w=0; w < workers.count(); w++)
-    {
-        workers[w]->setTasks(merge_task_list);
-        workers[w]->setMutex(mutex);
-    }
-    for (int w=0; w < workers.count(); w++)
+//Condition of a range of keys. An empty bound leaves the range open on that side
+QString mainClass::keyRange(QString table, QStringList keys, QString low, QString high)
+{
+    QStringList qualified_keys;
+    for (int k = 0; k < keys.count(); k++)
+        qualified_keys.append(table + "." + keys[k]);
+    QStringList conditions;
+    if (low != "")
+        conditions.append("(" + qualified_keys.join(",") + ") > " + low);
+    if (high != "")
+        conditions.append("(" + qualified_keys.join(",") + ") <= " + high);
+    return conditions.join(" AND ");
+}
+
+//Plans how the worker builds each column of the output. sources has the column of the query with the value
+//of each field. The description columns (-desc) are resolved from the code in their field
+QList<TresolveColumn> mainClass::getColumns(QStringList names, QStringList descfields, QHash<QString, int> sources, QVector<TlinkedTable> linked_tables, QVector<TmultiSelectTable> multiSelectTables)
+{
+    QList<TresolveColumn> columns;
+    for (int i = 0; i < names.count(); i++)
     {
-        workers[w]->start();
+        TresolveColumn a_column;
+        a_column.name = names[i];
+        QString code_field = a_column.name;
+        if (descfields.indexOf(a_column.name) >= 0)
+            code_field = a_column.name.left(a_column.name.length() - 5);
+        a_column.source = sources.value(code_field, -1);
+
+        for (int lkp = 0; lkp < linked_tables.count(); lkp++)
+        {
+            if (linked_tables[lkp].field == code_field)
+            {
+                a_column.action = 1;
+                a_column.lookupTable = linked_tables[lkp].related_table;
+                a_column.lookupField = linked_tables[lkp].related_field;
+                a_column.keepCode = (code_field == a_column.name);
+                if ((this->resolve_type != 2) && (code_field == a_column.name))
+                    a_column.action = 0;
+            }
+        }
+        for (int msel = 0; msel < multiSelectTables.count(); msel++)
+        {
+            if (multiSelectTables[msel].field == code_field)
+            {
+                a_column.action = 2;
+                if ((this->resolve_type == 2) || (code_field != a_column.name))
+                    a_column.action = 3;
+                a_column.lookupTable = multiSelectTables[msel].multiSelectRelTable;
+                a_column.lookupField = multiSelectTables[msel].multiSelectRelField;
+                a_column.multiSelect = msel;
+            }
+        }
+        columns.append(a_column);
     }
-    for (int w=0; w < workers.count(); w++)
+    return columns;
+}
+
+//Query with the codes of all the multi-selects of a chunk. The worker keeps them by the keys of their parent
+//row. Each row has the keys of the parent, the multi-select and the code
+QString mainClass::getMultiSelectSQL(QVector<TmultiSelectTable> multiSelectTables, QString parent, QStringList parent_keys, QString condition)
+{
+    if (multiSelectTables.count() == 0)
+        return "";
+    QStringList selects;
+    QStringList keys;
+    for (int k = 0; k < parent_keys.count(); k++)
+        keys.append("TA." + parent_keys[k]);
+    for (int msel = 0; msel < multiSelectTables.count(); msel++)
     {
-        workers[w]->wait();
+        QStringList wheres;
+        for (int a_key = 0; a_key < multiSelectTables[msel].multiSelectKeys.count(); a_key++)
+            wheres.append("TA." + multiSelectTables[msel].multiSelectKeys[a_key] + " = TB." + multiSelectTables[msel].multiSelectKeys[a_key]);
+        if (condition != "")
+            wheres.append(condition);
+        selects.append("(SELECT " + keys.join(",") + "," + QString::number(msel) + ",TB." + multiSelectTables[msel].multiSelectField + " FROM " + parent + " AS TA," + multiSelectTables[msel].multiSelectTable + " AS TB WHERE " + wheres.join(" AND ") + ")");
     }
-    for (int w=0; w < workers.count(); w++)
+    QStringList order;
+    for (int k = 1; k <= parent_keys.count() + 1; k++)
+        order.append(QString::number(k));
+    return selects.join(" UNION ALL ") + " ORDER BY " + order.join(",");
+}
+
+//Loads once the lookups used to resolve the codes. The workers share them
+int mainClass::loadLookups()
+{
+    for (int t = 0; t < json_task_list.count(); t++)
     {
-        if (workers[w]->status != 0)
-            return -1;
+        for (int col = 0; col < json_task_list[t].columns.count(); col++)
+        {
+            const TresolveColumn &column = json_task_list[t].columns[col];
+            if ((column.action != 1) && (column.action != 3))
+                continue;
+            if (lookups.contains(column.lookupTable + "." + column.lookupField))
+                continue;
+            QString desc_field = column.lookupField;
+            desc_field = desc_field.replace("_cod","_des");
+            QSqlQuery qry(db);
+            qry.setForwardOnly(true);
+            if (!qry.exec("SELECT " + column.lookupField + "," + desc_field + " FROM " + column.lookupTable))
+            {
+                log("Cannot read the lookup table " + column.lookupTable);
+                return 1;
+            }
+            QHash<QString, QString> descriptions;
+            while (qry.next())
+                descriptions.insert(qry.value(0).toString(), qry.value(1).toString());
+            lookups.insert(column.lookupTable + "." + column.lookupField, descriptions);
+        }
     }
     return 0;
 }
 
-QStringList mainClass::get_parts(int total, int parts)
+//Read-only mode. Instead of copying the table into temporary tables the chunks are read straight from the
+//table by ranges of its primary key. The worker resolves the lookups and multi-selects of each row
+int mainClass::addReadOnlyTasks(TtableDef table, QStringList fields, QStringList fields_for_create, QStringList descfields, QVector<TlinkedTable> linked_tables, QVector<TmultiSelectTable> multiSelectTables, QDir currDir)
 {
-    QStringList res;
-    int div = total / parts;
-    int start = 1;
-    int end = div;
-    if (parts >= total)
-    {
-        res.append("1|" + QString::number(total));
-        return res;
-    }
-    if (parts == 1)
+    QStringList select;
+    QHash<QString, int> sources;
+    for (int i = 0; i < fields_for_create.count(); i++)
     {
-        res.append("1|" + QString::number(total));
-        return res;
+        if (descfields.indexOf(fields_for_create[i]) >= 0)
+            continue;
+        if (fields[i].indexOf(" as ") < 0)
+            select.append("ifnull(" + table.name + ".`" + fields[i] + "`,'') as `" + fields[i] + "`");
+        else
+            select.append(fields[i]);
+        sources.insert(fields_for_create[i], select.count() - 1);
     }
-    if (total >= 500)
+    QList<TresolveColumn> columns = getColumns(fields_for_create, descfields, sources, linked_tables, multiSelectTables);
+
+    QStringList keys;
+    QList<int> key_sources;
+    for (int fld = 0; fld < table.fields.count(); fld++)
     {
-        for (int pos = 1; pos < parts; pos++)
+        if (table.fields[fld].isKey)
         {
-            res.append(QString::number(start) + "|" + QString::number(end));
-            start = end + 1 ;
-            end = start + div;
+            keys.append(table.fields[fld].name);
+            select.append(table.name + "." + table.fields[fld].name + " AS odktools_key_" + QString::number(keys.count()));
+            key_sources.append(select.count() - 1);
         }
-        res.append(QString::number(start) + "|" + QString::number(total));
     }
-    else
+    QStringList qualified_keys;
+    for (int k = 0; k < keys.count(); k++)
+        qualified_keys.append(table.name + "." + keys[k]);
+
+    QStringList lows;
+    QStringList highs;
+    if (getKeyRanges(table.name, keys, lows, highs) != 0)
+        return 1;
+
+    QDir finalDir(outputDirectory);
+    orderedWriter *a_writer = new orderedWriter(finalDir.absolutePath() + currDir.separator() + table.name + ".csv", num_workers * 2);
+    writers.append(a_writer);
+
+    for (int p = 0; p < lows.count(); p++)
     {
-        res.append("1|" + QString::number(total));
+        TtaskItem a_json_task;
+        a_json_task.task_type = 2;
+        a_json_task.table = table.name;
+        a_json_task.sql_file = currDir.absolutePath() + currDir.separator() + table.name + "_" + QString::number(p+1) + "_query.sql";
+        a_json_task.chunk_file = currDir.absolutePath() + currDir.separator() + table.name + "_" + QString::number(p+1) + ".chunk";
+        a_json_task.header = (p == 0);
+        a_json_task.writer = a_writer;
+        a_json_task.chunk = p;
+        a_json_task.columns = columns;
+        a_json_task.keys = key_sources;
+        a_json_task.multiSelect_sql = getMultiSelectSQL(multiSelectTables, table.name, keys, keyRange("TA", keys, lows[p], highs[p]));
+
+        QString sql = "SELECT " + select.join(",") + " FROM " + table.name;
+        QString condition = keyRange(table.name, keys, lows[p], highs[p]);
+        if (condition != "")
+            sql = sql + " WHERE " + condition;
+        if (keys.count() > 0)
+            sql = sql + " ORDER BY " + qualified_keys.join(",");
+        sql = sql + ";";
+        QFile sqlfile(a_json_task.sql_file);
+        if (!sqlfile.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+            return 1;
+        }
+        QTextStream out(&sqlfile);
+        out << sql;
+        sqlfile.close();
+
+        json_task_list.append(a_json_task);
     }
-    return res;
+    return 0;
 }
 
 int mainClass::generateXLSX()
@@ -595,6 +808,18 @@ int mainClass::generateXLSX()
                     }
                 }
 
+                if (this->readOnly)
+                {
+                    if (addReadOnlyTasks(tables[pos], fields, fields_for_create, descfields, linked_tables, multiSelectTables, currDir) != 0)
+                    {
+                        returnCode = 1;
+                        return returnCode;
+                    }
+                    linked_tables.clear();
+                    multiSelectTables.clear();
+                    continue;
+                }
+
                 QString temp_table;
 
                 QUuid recordUUID=QUuid::createUuid();
@@ -643,10 +868,11 @@ int mainClass::generateXLSX()
                 int tot_records = qry.value(0).toInt();
 
                 QStringList parts;
-                parts = get_parts(tot_records,num_workers*num_workers);
+                parts = get_parts(tot_records,getNumParts(tot_records));
 
                 //qDebug() <<"Creating files";
 
+                int first_part = separate_task_list.count();
                 for (int p = 0; p < parts.count(); p++)
                 {
                     QStringList sections = parts[p].split("|");
@@ -670,149 +896,25 @@ int mainClass::generateXLSX()
                             temout << "ALTER TABLE " + temp_table + "_" + QString::number(p+1) + " MODIFY COLUMN " + tables[pos].fields[fld].name + " VARCHAR(255) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci;\n";
                     }
 
-                    //Alter for multiselects
-                    if (multiSelectTables.count() == 0 && linked_tables.count() == 0)
-                    {
-                        if (descfields.count() > 0)
-                        {
-                            QStringList modifies;
-                            for (int i = 0; i < descfields.count(); i++)
-                            {
-                                modifies.append("MODIFY COLUMN `" + descfields[i] + "` TEXT");
-                            }
-                            temout << "ALTER TABLE " + temp_table + "_" + QString::number(p+1) + " " + modifies.join(",") + ";\n";
-
-                        }
-                    }
-                    if (multiSelectTables.count() > 0 && this->incmsels == false)
-                    {
-                        QStringList modifies;
-                        for (int i_table=0; i_table < multiSelectTables.count(); i_table++)
-                        {
-                            modifies.append("MODIFY COLUMN " + multiSelectTables[i_table].field + " TEXT");
-                            if (this->resolve_type == 3)
-                                modifies.append("MODIFY COLUMN `" + multiSelectTables[i_table].field + "-desc` TEXT");
-                        }
-                        temout << "ALTER TABLE " + temp_table + "_" + QString::number(p+1) + " " + modifies.join(",") + ";\n";
-                    }
-                    //Alter for lookups
-                    if (linked_tables.count() > 0)
-                    {
-                        QStringList modifies;
-                        for (int i_table=0; i_table < linked_tables.count(); i_table++)
-                        {
-                            sql = "MODIFY COLUMN ";
-                            if (this->resolve_type == 2)
-                                sql = sql +  linked_tables[i_table].field;
-                            else
-                                sql = sql + "`" + linked_tables[i_table].field + "-desc`";
-                            sql = sql + " TEXT";
-                            modifies.append(sql);
-                        }
-                        temout << "ALTER TABLE " + temp_table + "_" + QString::number(p+1) + " " + modifies.join(",") + ";\n";
-                    }
                     temout << "INSERT INTO " + temp_table + "_" + QString::number(p+1) + " SELECT * FROM " + temp_table + " WHERE `record-index` BETWEEN " + sections[0] + " AND " + sections[1] + ";\n";
 
                     tempfile.close();
                     separate_task_list.append(a_separation_task);
                 }
 
-                for (int p = 0; p < parts.count(); p++)
+                //The lookups and multi-selects are resolved by the workers. The codes of the multi-selects
+                //are read with the record index of the part so they come in the same order as its rows
+                QHash<QString, int> sources;
+                for (int fld = 0; fld < fields_for_create.count(); fld++)
                 {
-                    TtaskItem a_update_task;
-                    a_update_task.task_type = 1;
-                    a_update_task.table = temp_table;
-                    a_update_task.sql_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + "_" + QString::number(p+1) + "_update.sql";
-                    QFile tempfile(currDir.absolutePath() + currDir.separator() + tables[pos].name + "_" + QString::number(p+1) + "_update.sql");
-                    if (!tempfile.open(QIODevice::WriteOnly | QIODevice::Text))
-                    {
-                        return 1;
-                    }
-                    QTextStream temout(&tempfile);
-
-                    temout << "SET SQL_MODE = '';\n";
-
-                    //Update the lookup tables
-                    if (linked_tables.count() > 0)
-                    {
-                        for (int i_table=0; i_table < linked_tables.count(); i_table++)
-                        {
-                            sql = "UPDATE " + temp_table + "_" + QString::number(p+1) + "," + linked_tables[i_table].related_table + " AS T" + QString::number(i_table) + " SET ";
-                            QString relfield = linked_tables[i_table].related_field;
-                            if (this->resolve_type == 2)
-                                sql = sql + temp_table + "_" + QString::number(p+1) + "." + linked_tables[i_table].field + " = T" + QString::number(i_table) + "." + relfield.replace("_cod","_des");
-                            else
-                                sql = sql + temp_table + "_" + QString::number(p+1) + ".`" + linked_tables[i_table].field + "-desc` = T" + QString::number(i_table) + "." + relfield.replace("_cod","_des");
-                            sql = sql + " WHERE " + temp_table + "_" + QString::number(p+1) + "." + linked_tables[i_table].field + " = T" + QString::number(i_table) + "." + linked_tables[i_table].related_field + ";\n";
-                            temout << sql;
-                        }
-                    }
-                    //Update multiselects
-                    if (multiSelectTables.count() > 0 && this->incmsels == false)
-                    {
-                        for (int i_table=0; i_table < multiSelectTables.count(); i_table++)
-                        {
-                            if (this->resolve_type == 1 || this->resolve_type == 3)
-                            {
-                                sql = "UPDATE " + temp_table + "_" + QString::number(p+1) + " AS TA SET TA." + multiSelectTables[i_table].field + " = (SELECT GROUP_CONCAT(TB." + multiSelectTables[i_table].multiSelectField + " SEPARATOR ',') FROM " + multiSelectTables[i_table].multiSelectTable + " as TB";
-                                QStringList wheres;
-                                QStringList groups;
-                                for (int a_key = 0; a_key < multiSelectTables[i_table].multiSelectKeys.count(); a_key++)
-                                {
-                                    wheres.append("TA." + multiSelectTables[i_table].multiSelectKeys[a_key] + " = TB." + multiSelectTables[i_table].multiSelectKeys[a_key]);
-                                    groups.append("TB." + multiSelectTables[i_table].multiSelectKeys[a_key]);
-                                }
-                                sql = sql + " WHERE " + wheres.join(" AND ");
-                                sql = sql + " GROUP BY " + groups.join(",") + ");\n";
-                                temout << sql;
-                            }
-
-                            if (this->resolve_type == 2)
-                            {
-                                QString desc_field = multiSelectTables[i_table].multiSelectRelField;
-                                desc_field = desc_field.replace("_cod","_des");
-                                sql = "UPDATE " + temp_table + "_" + QString::number(p+1) + " AS TA SET TA." + multiSelectTables[i_table].field + " = (SELECT GROUP_CONCAT(TC." + desc_field + " SEPARATOR ',') FROM " + multiSelectTables[i_table].multiSelectTable + " as TB," +  multiSelectTables[i_table].multiSelectRelTable + " as TC";
-                                sql = sql + " WHERE TB." + multiSelectTables[i_table].multiSelectField + " = TC." + multiSelectTables[i_table].multiSelectRelField;
-                                QStringList wheres;
-                                QStringList groups;
-                                for (int a_key = 0; a_key < multiSelectTables[i_table].multiSelectKeys.count(); a_key++)
-                                {
-                                    wheres.append("TA." + multiSelectTables[i_table].multiSelectKeys[a_key] + " = TB." + multiSelectTables[i_table].multiSelectKeys[a_key]);
-                                    groups.append("TB." + multiSelectTables[i_table].multiSelectKeys[a_key]);
-                                }
-                                sql = sql + " AND " + wheres.join(" AND ");
-                                sql = sql + " GROUP BY " + groups.join(",") + ");\n";
-                                temout << sql;
-                            }
-
-                            if (this->resolve_type == 3)
-                            {
-                                QString desc_field = multiSelectTables[i_table].multiSelectRelField;
-                                desc_field = desc_field.replace("_cod","_des");
-                                sql = "UPDATE " + temp_table + "_" + QString::number(p+1) + " AS TA SET TA.`" + multiSelectTables[i_table].field + "-desc` = (SELECT GROUP_CONCAT(TC." + desc_field + " SEPARATOR ',') FROM " + multiSelectTables[i_table].multiSelectTable + " as TB," +  multiSelectTables[i_table].multiSelectRelTable + " as TC";
-                                sql = sql + " WHERE TB." + multiSelectTables[i_table].multiSelectField + " = TC." + multiSelectTables[i_table].multiSelectRelField;
-                                QStringList wheres;
-                                QStringList groups;
-                                for (int a_key = 0; a_key < multiSelectTables[i_table].multiSelectKeys.count(); a_key++)
-                                {
-                                    wheres.append("TA." + multiSelectTables[i_table].multiSelectKeys[a_key] + " = TB." + multiSelectTables[i_table].multiSelectKeys[a_key]);
-                                    groups.append("TB." + multiSelectTables[i_table].multiSelectKeys[a_key]);
-                                }
-                                sql = sql + " AND " + wheres.join(" AND ");
-                                sql = sql + " GROUP BY " + groups.join(",") + ");\n";
-                                temout << sql;
-                            }
-                        }
-                    }
-                    tempfile.close();
-                    update_task_list.append(a_update_task);
+                    if (descfields.indexOf(fields_for_create[fld]) < 0)
+                        sources.insert(fields_for_create[fld], fld);
                 }
+                QList<TresolveColumn> columns = getColumns(fields_for_create, descfields, sources, linked_tables, multiSelectTables);
 
                 QDir finalDir(outputDirectory);
-                TtaskItem a_merge_task;
-                a_merge_task.task_type = 3;
-                a_merge_task.table = temp_table;
-                a_merge_task.final_file = finalDir.absolutePath() + currDir.separator() + tables[pos].name + ".json";
+                orderedWriter *a_writer = new orderedWriter(finalDir.absolutePath() + currDir.separator() + tables[pos].name + ".csv", num_workers * 2);
+                writers.append(a_writer);
 
 
                 for (int p = 0; p < parts.count(); p++)
@@ -822,9 +924,12 @@ int mainClass::generateXLSX()
                     a_json_task.table = temp_table;
 
                     a_json_task.sql_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + "_" + QString::number(p+1) + "_query.sql";
-                    a_json_task.json_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + "_" + QString::number(p+1) + ".json";
+                    a_json_task.chunk_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + "_" + QString::number(p+1) + ".chunk";
+                    a_json_task.header = (p == 0);
 
-                    a_merge_task.json_files.append(currDir.absolutePath() + currDir.separator() + tables[pos].name + "_" + QString::number(p+1) + ".json");
+                    a_json_task.writer = a_writer;
+                    a_json_task.chunk = p;
+                    a_json_task.depends = first_part + p; //The part must be created first
 
                     QStringList fields_to_select;
                     for (int fld =0; fld < fields_for_select.count(); fld++)
@@ -834,8 +939,12 @@ int mainClass::generateXLSX()
                         else
                             fields_to_select.append(fields_for_select[fld]);
                     }
+                    fields_to_select.append("`record-index` AS odktools_key_1");
+                    a_json_task.columns = columns;
+                    a_json_task.keys.append(fields_to_select.count() - 1);
+                    a_json_task.multiSelect_sql = getMultiSelectSQL(multiSelectTables, temp_table + "_" + QString::number(p+1), QStringList("`record-index`"), "");
 
-                    sql = "SELECT " + fields_to_select.join(",") + " FROM " + temp_table + "_" + QString::number(p+1) + ";";
+                    sql = "SELECT " + fields_to_select.join(",") + " FROM " + temp_table + "_" + QString::number(p+1) + " ORDER BY `record-index`;";
                     QFile sqlfile(currDir.absolutePath() + currDir.separator() + tables[pos].name + "_" + QString::number(p+1) + "_query.sql");
                     if (!sqlfile.open(QIODevice::WriteOnly | QIODevice::Text))
                     {
@@ -848,7 +957,6 @@ int mainClass::generateXLSX()
                     json_task_list.append(a_json_task);
 
                 }
-                merge_task_list.append(a_merge_task);
 
 
                 linked_tables.clear();
@@ -858,10 +966,8 @@ int mainClass::generateXLSX()
             QDir finalDir(outputDirectory);
             for (int lkp = 0; lkp < lookupTables.count(); lkp++)
             {
-                TtaskItem a_merge_task;
-                a_merge_task.task_type = 4;
-                a_merge_task.table = lookupTables[lkp].name;
-                a_merge_task.final_file = finalDir.absolutePath() + currDir.separator() + lookupTables[lkp].name + ".json";
+                orderedWriter *a_writer = new orderedWriter(finalDir.absolutePath() + currDir.separator() + lookupTables[lkp].name + ".csv", 1);
+                writers.append(a_writer);
 
 
                 TtaskItem a_json_task;
@@ -869,9 +975,10 @@ int mainClass::generateXLSX()
                 a_json_task.table = lookupTables[lkp].name;
 
                 a_json_task.sql_file = currDir.absolutePath() + currDir.separator() + lookupTables[lkp].name + "_query.sql";
-                a_json_task.json_file = currDir.absolutePath() + currDir.separator() + lookupTables[lkp].name + ".json";
+                a_json_task.chunk_file = currDir.absolutePath() + currDir.separator() + lookupTables[lkp].name + ".chunk";
+                a_json_task.header = true;
 
-                a_merge_task.json_files.append(currDir.absolutePath() + currDir.separator() + lookupTables[lkp].name + ".json");
+                a_json_task.writer = a_writer;
 
                 fields.clear();
                 descfields.clear();
@@ -913,7 +1020,6 @@ int mainClass::generateXLSX()
                 sqlfile.close();
 
                 json_task_list.append(a_json_task);
-                merge_task_list.append(a_merge_task);
             }
         }
         else
@@ -924,10 +1030,8 @@ int mainClass::generateXLSX()
             QDir finalDir(outputDirectory);
             for (int pos = 0; pos < tables.count(); pos++)
             {
-                TtaskItem a_merge_task;
-                a_merge_task.task_type = 4;
-                a_merge_task.table = tables[pos].name;
-                a_merge_task.final_file = finalDir.absolutePath() + currDir.separator() + tables[pos].name + ".json";
+                orderedWriter *a_writer = new orderedWriter(finalDir.absolutePath() + currDir.separator() + tables[pos].name + ".csv", 1);
+                writers.append(a_writer);
 
 
                 TtaskItem a_json_task;
@@ -935,9 +1039,10 @@ int mainClass::generateXLSX()
                 a_json_task.table = tables[pos].name;
 
                 a_json_task.sql_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + "_query.sql";
-                a_json_task.json_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + ".json";
+                a_json_task.chunk_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + ".chunk";
+                a_json_task.header = true;
 
-                a_merge_task.json_files.append(currDir.absolutePath() + currDir.separator() + tables[pos].name + ".json");
+                a_json_task.writer = a_writer;
 
 
                 fields.clear();
@@ -980,14 +1085,28 @@ int mainClass::generateXLSX()
                 sqlfile.close();
 
                 json_task_list.append(a_json_task);
-                merge_task_list.append(a_merge_task);
 
             }
         }
 
         //exit(1);
 
-        int result = processTasks(currDir);
+        int result = 0;
+        for (int w = 0; w < writers.count(); w++)
+        {
+            if (writers[w]->create() != 0)
+            {
+                log("Cannot create file " + writers[w]->fileName());
+                result = 1;
+                break;
+            }
+        }
+        if (result == 0)
+            result = loadLookups();
+        if (result == 0)
+            result = processTasks(currDir);
+        qDeleteAll(writers);
+        writers.clear();
         QSqlQuery drop(db);
         for (int d=0; d < drops.count(); d++)
         {
@@ -5,6 +5,11 @@
 #include <QDomNode>
 #include <QDir>
 #include <QSqlDatabase>
+#include <QHash>
+
+//QMYSQL stores the whole result of a query in the client (mysql_store_result), even for forward only queries,
+//so the tables are split in chunks of up to this number of rows to bound the memory of each worker
+#define CHUNK_ROWS 100000
 
 struct fieldDef
 {
@@ -59,14 +64,34 @@ struct multiSelectTable
 };
 typedef multiSelectTable TmultiSelectTable;
 
+//How a column of the output is built from the query of a chunk
+struct resolveColumn
+{
+    QString name; //Name of the column in the output
+    int source = -1; //Column of the query with the value or the code
+    int action = 0; //0=Value as is, 1=Lookup description, 2=Multi-select codes, 3=Multi-select descriptions
+    QString lookupTable; //Lookup table with the descriptions
+    QString lookupField; //Code field of the lookup table. The description is the same field ending in _des
+    bool keepCode = false; //Use the code if the lookup has no description for it
+    int multiSelect = -1; //Index of the multi-select query of the chunk
+};
+typedef resolveColumn TresolveColumn;
+
+class orderedWriter;
+
 struct taskItem
 {
     QString table;
     int task_type;
     QString sql_file;
-    QString json_file;
-    QStringList json_files;
-    QString final_file;
+    QString chunk_file;
+    bool header = false;
+    QList<TresolveColumn> columns; //Empty if the query already has the output
+    QList<int> keys; //Columns of the query with the keys of the row
+    QString multiSelect_sql; //Codes of the multi-selects of the rows
+    orderedWriter *writer = nullptr;
+    int chunk = 0;
+    int depends = -1; //Task that must finish before this one starts. -1 if none
 };
 typedef taskItem TtaskItem;
 
@@ -75,7 +100,7 @@ class mainClass : public QObject
     Q_OBJECT
 public:
     explicit mainClass(QObject *parent = nullptr);
-    void setParameters(QString host, QString port, QString user, QString pass, QString schema, QString createXML, QString outputDir, bool protectSensitive, QString tempDir, bool incLookups, bool incmsels, QString encryption_key, QString resolve_type, int num_workers);
+    void setParameters(QString host, QString port, QString user, QString pass, QString schema, QString createXML, QString outputDir, bool protectSensitive, QString tempDir, bool incLookups, bool incmsels, QString encryption_key, QString resolve_type, int num_workers, bool readOnly);
     int returnCode;
 signals:
     void finished();
@@ -89,6 +114,13 @@ private:
     void loadTable(QDomNode node);
     void getMultiSelectInfo(QDomNode table, QString table_name, QString &multiSelect_field, QStringList &keys, QString &rel_table, QString &rel_field);
     QStringList get_parts(int total, int parts);
+    int getNumParts(int total);
+    int getKeyRanges(QString table, QStringList keys, QStringList &lows, QStringList &highs);
+    QString keyRange(QString table, QStringList keys, QString low, QString high);
+    QList<TresolveColumn> getColumns(QStringList names, QStringList descfields, QHash<QString, int> sources, QVector<TlinkedTable> linked_tables, QVector<TmultiSelectTable> multiSelectTables);
+    QString getMultiSelectSQL(QVector<TmultiSelectTable> multiSelectTables, QString parent, QStringList parent_keys, QString condition);
+    int loadLookups();
+    int addReadOnlyTasks(TtableDef table, QStringList fields, QStringList fields_for_create, QStringList descfields, QVector<TlinkedTable> linked_tables, QVector<TmultiSelectTable> multiSelectTables, QDir currDir);
     QString host;
     QString port;
     QString user;
@@ -108,11 +140,12 @@ private:
     int letterIndex;
     bool incLookups;
     bool incmsels;    
+    bool readOnly;
     QStringList protectedKeys;    
     QList< TtaskItem> separate_task_list;
-    QList< TtaskItem> update_task_list;
     QList< TtaskItem> json_task_list;
-    QList< TtaskItem> merge_task_list;
+    QList<orderedWriter*> writers;
+    QHash<QString, QHash<QString, QString> > lookups;
     QSqlDatabase db;
 };
 
@@ -0,0 +1,114 @@
+#include "orderedwriter.h"
+#include <QFile>
+#include <QMutexLocker>
+
+orderedWriter::orderedWriter(QString fileName, int window)
+{
+    finalFile = fileName;
+    this->window = window;
+    if (this->window < 1)
+        this->window = 1;
+    next = 0;
+    aborted = false;
+}
+
+QString orderedWriter::fileName()
+{
+    return finalFile;
+}
+
+//Creates the final file empty
+int orderedWriter::create()
+{
+    QFile file(finalFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return 1;
+    file.close();
+    return 0;
+}
+
+//True if beginChunk would not wait for the chunk. A failed file lets its chunks begin so they end at once
+bool orderedWriter::canBegin(int chunk)
+{
+    QMutexLocker locker(&mutex);
+    return (chunk < next + window) || aborted;
+}
+
+//Waits until the chunk is inside the window. Returns 0 if the chunk is the head and must be
+//appended directly to the final file, 1 if it must be written to its temporary file and -1 if
+//another chunk of the file failed
+int orderedWriter::beginChunk(int chunk)
+{
+    QMutexLocker locker(&mutex);
+    while ((chunk >= next + window) && (!aborted))
+        advanced.wait(&mutex);
+    if (aborted)
+        return -1;
+    if (chunk == next)
+        return 0;
+    return 1;
+}
+
+int orderedWriter::appendFile(QString chunkFile)
+{
+    QFile final_file(finalFile);
+    if (!final_file.open(QIODevice::WriteOnly | QIODevice::Append))
+        return 1;
+    QFile chunk(chunkFile);
+    if (!chunk.open(QIODevice::ReadOnly))
+        return 1;
+    while (!chunk.atEnd())
+    {
+        if (final_file.write(chunk.read(1048576)) < 0)
+            return 1;
+    }
+    chunk.close();
+    chunk.remove();
+    final_file.close();
+    if (final_file.error() != QFileDevice::NoError)
+        return 1;
+    return 0;
+}
+
+//Marks a chunk as finished. chunkFile is empty if the chunk was appended directly.
+//The chunks waiting for it are appended in order
+int orderedWriter::endChunk(int chunk, QString chunkFile)
+{
+    QMutexLocker locker(&mutex);
+    if (aborted)
+        return 1;
+    if (chunk != next)
+    {
+        pending.insert(chunk, chunkFile);
+        return 0;
+    }
+    if (chunkFile != "")
+    {
+        if (appendFile(chunkFile) != 0)
+        {
+            aborted = true;
+            advanced.wakeAll();
+            return 1;
+        }
+    }
+    next++;
+    while (pending.contains(next))
+    {
+        if (appendFile(pending.take(next)) != 0)
+        {
+            aborted = true;
+            advanced.wakeAll();
+            return 1;
+        }
+        next++;
+    }
+    advanced.wakeAll();
+    return 0;
+}
+
+void orderedWriter::abort()
+{
+    QMutexLocker locker(&mutex);
+    aborted = true;
+    advanced.wakeAll();
+}
@@ -0,0 +1,35 @@
+#ifndef ORDEREDWRITER_H
+#define ORDEREDWRITER_H
+
+#include <QString>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+
+//Assembles the final CSV of a table from chunks extracted in parallel.
+//The chunk at the head of the file is streamed straight into it. The chunks that finish
+//before their turn are kept in their temporary files and appended as soon as the ones
+//before them are written. A worker cannot start a chunk more than "window" chunks ahead
+//of the head, so only a few temporary chunks exist at any time
+class orderedWriter
+{
+public:
+    orderedWriter(QString fileName, int window);
+    int create();
+    bool canBegin(int chunk);
+    int beginChunk(int chunk);
+    int endChunk(int chunk, QString chunkFile);
+    void abort();
+    QString fileName();
+private:
+    int appendFile(QString chunkFile);
+    QString finalFile;
+    int window;
+    int next;
+    bool aborted;
+    QMap<int, QString> pending;
+    QMutex mutex;
+    QWaitCondition advanced;
+};
+
+#endif // ORDEREDWRITER_H
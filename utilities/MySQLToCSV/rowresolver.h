@@ -0,0 +1,33 @@
+#ifndef ROWRESOLVER_H
+#define ROWRESOLVER_H
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QHash>
+#include "mainclass.h"
+
+//Builds the rows of a chunk resolving the lookups and multi-selects in memory. The lookups are shared
+//dictionaries loaded once by mainClass. The codes of the multi-selects of the chunk are read by a second
+//query and kept by the key of their row, so no UPDATE runs in the server
+class rowResolver
+{
+public:
+    rowResolver();
+    void setLookups(const QHash<QString, QHash<QString, QString> > *lookups);
+    int prepare(QSqlDatabase &db, TtaskItem task);
+    QStringList header();
+    QStringList resolve(const QSqlRecord &record);
+    int finish();
+    QString lastError();
+private:
+    QString getKey(const QSqlRecord &record, QList<int> keys);
+    const QHash<QString, QHash<QString, QString> > *lookups;
+    QList<TresolveColumn> columns;
+    QList<int> keys;
+    QHash<QString, QList<QStringList> > chunkCodes;
+    QList<QStringList> codes;
+    QString error;
+};
+
+#endif // ROWRESOLVER_H
@@ -0,0 +1,115 @@
+#include "rowwriter.h"
+#include <QVariant>
+#include <QDateTime>
+
+rowWriter::rowWriter()
+{
+    numRows = 0;
+}
+
+rowWriter::~rowWriter()
+{
+    if (file.isOpen())
+        file.close();
+}
+
+int rowWriter::open(QString fileName, bool append)
+{
+    numRows = 0;
+    file.setFileName(fileName);
+    if (append)
+    {
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+            return 1;
+    }
+    else
+    {
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            return 1;
+    }
+    return 0;
+}
+
+void rowWriter::writeValue(int column, QString value)
+{
+    if (column > 0)
+        line.append(',');
+    line.append('"');
+    line.append(value.replace("\"","\"\"").toUtf8());
+    line.append('"');
+}
+
+void rowWriter::writeHeader(const QSqlRecord &record)
+{
+    line.clear();
+    for (int col = 0; col < record.count(); col++)
+        writeValue(col, record.fieldName(col));
+    line.append('\n');
+    file.write(line);
+}
+
+void rowWriter::writeRow(const QSqlRecord &record)
+{
+    line.clear();
+    for (int col = 0; col < record.count(); col++)
+    {
+        if (record.isNull(col))
+            writeValue(col, "");
+        else
+            writeValue(col, textValue(record.value(col)));
+    }
+    line.append('\n');
+    file.write(line);
+    numRows++;
+}
+
+void rowWriter::writeHeader(const QStringList &names)
+{
+    line.clear();
+    for (int col = 0; col < names.count(); col++)
+        writeValue(col, names[col]);
+    line.append('\n');
+    file.write(line);
+}
+
+void rowWriter::writeRow(const QStringList &values)
+{
+    line.clear();
+    for (int col = 0; col < values.count(); col++)
+        writeValue(col, values[col]);
+    line.append('\n');
+    file.write(line);
+    numRows++;
+}
+
+int rowWriter::rows()
+{
+    return numRows;
+}
+
+//The values are written as MySQL writes them: the dates are not in ISO format and the decimals keep
+//their digits because the queries of the chunks read the numbers with QSql::HighPrecision
+QString rowWriter::textValue(const QVariant &value)
+{
+    switch (value.type())
+    {
+    case QVariant::DateTime:
+        return value.toDateTime().toString("yyyy-MM-dd HH:mm:ss");
+    case QVariant::Date:
+        return value.toDate().toString("yyyy-MM-dd");
+    case QVariant::Time:
+        return value.toTime().toString("HH:mm:ss");
+    default:
+        return value.toString();
+    }
+}
+
+int rowWriter::close()
+{
+    if (!file.isOpen())
+        return 0;
+    file.close();
+    if (file.error() != QFileDevice::NoError)
+        return 1;
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef ROWWRITER_H
+#define ROWWRITER_H
+
+#include <QFile>
+#include <QSqlRecord>
+#include <QVariant>
+
+//Writes the rows of a query result to a CSV file as they are fetched from the server.
+//Every value is quoted and the quotes inside it doubled, the same as json2csv did
+class rowWriter
+{
+public:
+    rowWriter();
+    ~rowWriter();
+    int open(QString fileName, bool append = false);
+    void writeHeader(const QSqlRecord &record);
+    void writeRow(const QSqlRecord &record);
+    void writeHeader(const QStringList &names);
+    void writeRow(const QStringList &values);
+    int close();
+    int rows();
+    static QString textValue(const QVariant &value);
+private:
+    void writeValue(int column, QString value);
+    QFile file;
+    QByteArray line;
+    int numRows;
+};
+
+#endif // ROWWRITER_H
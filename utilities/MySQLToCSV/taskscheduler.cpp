@@ -0,0 +1,78 @@
+#include "taskscheduler.h"
+#include <QMutexLocker>
+#include "orderedwriter.h"
+
+taskScheduler::taskScheduler()
+{
+    first = 0;
+    done = 0;
+    aborted = false;
+}
+
+void taskScheduler::setTasks(const QList<TtaskItem> &task_list)
+{
+    depends.clear();
+    writers.clear();
+    chunks.clear();
+    states.clear();
+    for (int pos = 0; pos < task_list.count(); pos++)
+    {
+        depends.append(task_list[pos].depends);
+        writers.append(task_list[pos].writer);
+        chunks.append(task_list[pos].chunk);
+        states.append(0);
+    }
+    first = 0;
+    done = 0;
+    aborted = false;
+}
+
+//Called with the mutex locked
+bool taskScheduler::isReady(int index)
+{
+    if (states[index] != 0)
+        return false;
+    if ((depends[index] >= 0) && (states[depends[index]] != 2))
+        return false;
+    if (writers[index] != nullptr)
+        return writers[index]->canBegin(chunks[index]);
+    return true;
+}
+
+//Waits until a task is ready and returns its index. Returns -1 when all the tasks are done or a task failed
+int taskScheduler::getTask()
+{
+    QMutexLocker locker(&mutex);
+    while (true)
+    {
+        if ((aborted) || (done == states.count()))
+            return -1;
+        while ((first < states.count()) && (states[first] != 0))
+            first++;
+        for (int pos = first; pos < states.count(); pos++)
+        {
+            if (isReady(pos))
+            {
+                states[pos] = 1;
+                return pos;
+            }
+        }
+        changed.wait(&mutex);
+    }
+}
+
+//A finished task can release the tasks that depend on it and, if it was a chunk, move the window of its file
+void taskScheduler::taskDone(int index)
+{
+    QMutexLocker locker(&mutex);
+    states[index] = 2;
+    done++;
+    changed.wakeAll();
+}
+
+void taskScheduler::abort()
+{
+    QMutexLocker locker(&mutex);
+    aborted = true;
+    changed.wakeAll();
+}
@@ -0,0 +1,34 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include "mainclass.h"
+
+//Hands out the tasks of all the tables to the workers. A task is ready when the task it
+//depends on has finished and, for a chunk, when the ordered writer of its file can take it
+//without waiting. An idle worker takes the first ready task of any table so a slow table
+//does not hold the rest until a phase ends
+class taskScheduler
+{
+public:
+    taskScheduler();
+    void setTasks(const QList<TtaskItem> &task_list);
+    int getTask();
+    void taskDone(int index);
+    void abort();
+private:
+    bool isReady(int index);
+    QList<int> depends;
+    QList<orderedWriter*> writers;
+    QList<int> chunks;
+    QList<int> states; //0 waiting, 1 running, 2 done
+    int first;
+    int done;
+    bool aborted;
+    QMutex mutex;
+    QWaitCondition changed;
+};
+
+#endif // TASKSCHEDULER_H
@@ -21,9 +21,11 @@ unix:INCLUDEPATH += ../../3rdparty
 SOURCES += main.cpp \
     jsonworker.cpp \
     listmutex.cpp \
-    mainclass.cpp
+    mainclass.cpp \
+    rowwriter.cpp
 
 HEADERS += \
     jsonworker.h \
     listmutex.h \
-    mainclass.h
+    mainclass.h \
+    rowwriter.h
@@ -2,11 +2,11 @@
 #include <QFile>
 #include <QTextStream>
 #include <QFileInfo>
-#include <QProcess>
 #include <QDebug>
-#include <QProcessEnvironment>
-#include <QUuid>
-#include <QUrl>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSqlRecord>
+#include "rowwriter.h"
 
 JSONWorker::JSONWorker(QObject *parent)
     : QThread{parent}
@@ -37,134 +37,190 @@ void JSONWorker::log(QString message)
     printf("%s", temp.toUtf8().data());
 }
 
+//Each worker has its own connection. A connection can only be used by the thread that created it
+int JSONWorker::openConnection(QSqlDatabase &db)
+{
+    db = QSqlDatabase::addDatabase("QMYSQL",name);
+    db.setHostName(host);
+    db.setPort(port.toInt());
+    db.setDatabaseName(schema);
+    db.setUserName(user);
+    db.setPassword(pass);
+    if (!db.open())
+    {
+        log(name + " - Error while conneting to MySQL: " + db.lastError().databaseText());
+        return 1;
+    }
+    QSqlQuery qry(db);
+    qry.exec("SET NAMES utf8mb4");
+    return 0;
+}
+
+//Runs the statements of a SQL file one by one. The files are created by mainClass with one statement per line
+int JSONWorker::execSQLFile(QSqlDatabase &db, QString sql_file)
+{
+    QFile file(sql_file);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        log("Cannot open SQL file " + sql_file);
+        return 1;
+    }
+    QString sql = QString::fromUtf8(file.readAll());
+    file.close();
+
+    QStringList statements = sql.split(";\n");
+    QSqlQuery qry(db);
+    for (int pos = 0; pos < statements.count(); pos++)
+    {
+        QString statement = statements[pos].trimmed();
+        if (statement.endsWith(";"))
+            statement.chop(1);
+        if (statement.isEmpty())
+            continue;
+        if (!qry.exec(statement))
+        {
+            log(qry.lastError().databaseText());
+            log("Running statement:" + statement);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//Writes the result of the query of a chunk into its file. The driver stores the whole result of the
+//query in memory, so the size of the chunks (CHUNK_ROWS) bounds the memory of the worker
+int JSONWorker::exportQuery(QSqlDatabase &db, TtaskItem task)
+{
+    QFile file(task.sql_file);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        log("Cannot open SQL file " + task.sql_file);
+        return 1;
+    }
+    QString sql = QString::fromUtf8(file.readAll()).trimmed();
+    file.close();
+    if (sql.endsWith(";"))
+        sql.chop(1);
+
+    rowWriter writer;
+    if (writer.open(task.chunk_file) != 0)
+    {
+        log("Cannot create file " + task.chunk_file);
+        return 1;
+    }
+    QSqlQuery qry(db);
+    qry.setForwardOnly(true);
+    qry.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    if (!qry.exec(sql))
+    {
+        log(qry.lastError().databaseText());
+        log("Running query:" + sql);
+        return 1;
+    }
+    if (task.header)
+        writer.writeHeader(qry.record());
+    while (qry.next())
+        writer.writeRow(qry.record());
+    if (qry.lastError().isValid())
+    {
+        log(qry.lastError().databaseText());
+        return 1;
+    }
+    if (writer.close() != 0)
+    {
+        log("Error writing file " + task.chunk_file);
+        return 1;
+    }
+    return 0;
+}
+
+//Joins the chunks of a table into one JSON array in chunk order
+int JSONWorker::mergeChunks(TtaskItem task)
+{
+    QFile final_file(task.final_file);
+    if (!final_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        log("Cannot create file " + task.final_file);
+        return 1;
+    }
+    final_file.write("[\n");
+    bool first = true;
+    for (int f=0; f < task.chunk_files.count(); f++)
+    {
+        QFile chunk(task.chunk_files[f]);
+        if (!chunk.open(QIODevice::ReadOnly))
+        {
+            log("Cannot open file " + task.chunk_files[f]);
+            return 1;
+        }
+        if (chunk.size() > 0)
+        {
+            if (!first)
+                final_file.write(",\n");
+            first = false;
+            while (!chunk.atEnd())
+            {
+                if (final_file.write(chunk.read(1048576)) < 0)
+                {
+                    log("Error writing file " + task.final_file);
+                    return 1;
+                }
+            }
+        }
+        chunk.close();
+        chunk.remove();
+    }
+    final_file.write("\n]\n");
+    final_file.close();
+    return 0;
+}
+
 void JSONWorker::run()
 {
-    QProcess *mySQLDumpProcess = new QProcess();
-    QStringList arguments;
-    QString fixed_pass(QUrl::toPercentEncoding(pass));
-    QString fixed_user(QUrl::toPercentEncoding(user));
-    QString uri = fixed_user + ":" + fixed_pass + "@" + host + ":" + port +  "/" + schema;
-
-    int index = mutex->get_index();
-    //qDebug() << name + " - Processing index: " + QString::number(index);
+    QSqlDatabase db;
+    this->status = 0;
+    if (openConnection(db) != 0)
+        this->status = 1;
+
+    int index = -1;
+    if (this->status == 0)
+        index = mutex->get_index();
     while (index >= 0)
     {
         //qDebug() << name + " - Processing index: " + QString::number(index);
         // Create the table
         if (task_list[index].task_type == 1)
         {
-            //qDebug() << name + " - Processing file: " + task_list[index].sql_file;
-            arguments.clear();
-            arguments.append("--host=" + this->host);
-            arguments.append("--port=" + this->port);
-            arguments.append("--password=" + this->pass);
-            arguments.append("--user=" + this->user);
-            arguments.append("--database=" + this->schema);
-
-            mySQLDumpProcess->setStandardInputFile(task_list[index].sql_file);
-            mySQLDumpProcess->setStandardOutputFile(QProcess::nullDevice());
-            mySQLDumpProcess->start("mysql", arguments);
-            mySQLDumpProcess->waitForFinished(-1);
-            if (mySQLDumpProcess->exitCode() > 0)
+            if (execSQLFile(db, task_list[index].sql_file) != 0)
             {
-                QString serror = mySQLDumpProcess->readAllStandardError();
-                log(serror);
-                delete mySQLDumpProcess;
                 this->status = 1;
-                return;
+                break;
             }
         }
+        // Extract a chunk
         if (task_list[index].task_type == 2)
         {
-            QUuid home_id=QUuid::createUuid();
-            QString user_home_id=home_id.toString().replace("{","").replace("}","");
-            QFileInfo finfo(task_list[index].sql_file);
-            QString user_home = finfo.canonicalPath() + "/" + user_home_id;
-            QDir().mkdir(user_home);
-
-//            QFile options_file(user_home + "/options.json");
-//            options_file.open(QIODevice::WriteOnly);
-//            options_file.close();
-
-            QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-            env.insert("MYSQLSH_USER_CONFIG_HOME", user_home);
-
-            arguments.clear();
-            arguments << "--sql";
-            arguments << "--result-format=json/array";
-            arguments << "--uri=" + uri;
-
-            mySQLDumpProcess->setProcessEnvironment(env);
-            mySQLDumpProcess->setStandardInputFile(task_list[index].sql_file);
-            mySQLDumpProcess->setStandardOutputFile(task_list[index].json_file);
-            mySQLDumpProcess->start("mysqlsh", arguments);
-            mySQLDumpProcess->waitForFinished(-1);
-            if ((mySQLDumpProcess->exitCode() > 0) || (mySQLDumpProcess->error() == QProcess::FailedToStart))
+            if (exportQuery(db, task_list[index]) != 0)
             {
-                if (mySQLDumpProcess->error() == QProcess::FailedToStart)
-                {
-                    log("Error: Command mysqlsh not found");
-                }
-                else
-                {
-                    log("Running mysqlsh returned error");
-                    QString serror = mySQLDumpProcess->readAllStandardError();
-                    log(serror);
-                    log("Running paremeters:" + arguments.join(" "));
-                }
-                delete mySQLDumpProcess;
                 this->status = 1;
-                return;
-            }
-            else
-            {
-                this->msleep(500);
+                break;
             }
         }
-        if (task_list[index].task_type == 3)
+        // Merge the chunks into the final file
+        if ((task_list[index].task_type == 3) || (task_list[index].task_type == 4))
         {
-            //qDebug() << name + " - Creating final file: " + task_list[index].final_file;
-            arguments.clear();
-            arguments << "-s";
-            arguments << "reduce .[] as $x ([]; . + $x)";
-            for (int f=0; f < task_list[index].json_files.count(); f++)
-            {
-                arguments << task_list[index].json_files[f];
-            }
-            mySQLDumpProcess->setStandardInputFile(QProcess::nullDevice());
-            mySQLDumpProcess->setStandardOutputFile(task_list[index].final_file);
-
-            mySQLDumpProcess->start("jq", arguments);
-            mySQLDumpProcess->waitForFinished(-1);
-            if ((mySQLDumpProcess->exitCode() > 0) || (mySQLDumpProcess->error() == QProcess::FailedToStart))
+            if (mergeChunks(task_list[index]) != 0)
             {
-                if (mySQLDumpProcess->error() == QProcess::FailedToStart)
-                {
-                    log("Error: Command jq not found");
-                }
-                else
-                {
-                    log("Running jq returned error");
-                    QString serror = mySQLDumpProcess->readAllStandardError();
-                    log(serror);
-                    log("Running paremeters:" + arguments.join(" "));
-                }
-                delete mySQLDumpProcess;
                 this->status = 1;
-                return;
+                break;
             }
-
-        }
-        if (task_list[index].task_type == 4)
-        {
-            //qDebug() << "Moving:" + task_list[index].final_file;
-            QFile::copy(task_list[index].json_files[0],task_list[index].final_file);
         }
         index = mutex->get_index();
     }
 
-    delete mySQLDumpProcess;
-    this->status = 0;
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(name);
 }
 
 void JSONWorker::setTasks(QList< TtaskItem> task_list)
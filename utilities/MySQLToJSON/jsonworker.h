@@ -3,6 +3,7 @@
 
 #include <QThread>
 #include <QDir>
+#include <QSqlDatabase>
 #include "listmutex.h"
 #include "mainclass.h"
 
@@ -29,6 +30,10 @@ public:
     int status;
 private:
     void log(QString message);
+    int openConnection(QSqlDatabase &db);
+    int execSQLFile(QSqlDatabase &db, QString sql_file);
+    int exportQuery(QSqlDatabase &db, TtaskItem task);
+    int mergeChunks(TtaskItem task);
     QList< TtaskItem> task_list;
     ListMutex *mutex;
     QString host;
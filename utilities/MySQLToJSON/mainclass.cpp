@@ -336,6 +336,15 @@ QStringList mainClass::get_parts(int total, int parts)
     return res;
 }
 
+//The tables are split in num_workers * num_workers chunks, or more if a chunk would have more than CHUNK_ROWS rows
+int mainClass::getNumParts(int total)
+{
+    int parts = num_workers * num_workers;
+    if (total / parts >= CHUNK_ROWS)
+        parts = total / CHUNK_ROWS + 1;
+    return parts;
+}
+
 int mainClass::generateXLSX()
 {
 
@@ -643,7 +652,7 @@ int mainClass::generateXLSX()
                 int tot_records = qry.value(0).toInt();
 
                 QStringList parts;
-                parts = get_parts(tot_records,num_workers*num_workers);
+                parts = get_parts(tot_records,getNumParts(tot_records));
 
                 //qDebug() <<"Creating files";
 
@@ -822,9 +831,10 @@ int mainClass::generateXLSX()
                     a_json_task.table = temp_table;
 
                     a_json_task.sql_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + "_" + QString::number(p+1) + "_query.sql";
-                    a_json_task.json_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + "_" + QString::number(p+1) + ".json";
+                    a_json_task.chunk_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + "_" + QString::number(p+1) + ".chunk";
+                    a_json_task.header = (p == 0);
 
-                    a_merge_task.json_files.append(currDir.absolutePath() + currDir.separator() + tables[pos].name + "_" + QString::number(p+1) + ".json");
+                    a_merge_task.chunk_files.append(a_json_task.chunk_file);
 
                     QStringList fields_to_select;
                     for (int fld =0; fld < fields_for_select.count(); fld++)
@@ -869,9 +879,10 @@ int mainClass::generateXLSX()
                 a_json_task.table = lookupTables[lkp].name;
 
                 a_json_task.sql_file = currDir.absolutePath() + currDir.separator() + lookupTables[lkp].name + "_query.sql";
-                a_json_task.json_file = currDir.absolutePath() + currDir.separator() + lookupTables[lkp].name + ".json";
+                a_json_task.chunk_file = currDir.absolutePath() + currDir.separator() + lookupTables[lkp].name + ".chunk";
+                a_json_task.header = true;
 
-                a_merge_task.json_files.append(currDir.absolutePath() + currDir.separator() + lookupTables[lkp].name + ".json");
+                a_merge_task.chunk_files.append(a_json_task.chunk_file);
 
                 fields.clear();
                 descfields.clear();
@@ -935,9 +946,10 @@ int mainClass::generateXLSX()
                 a_json_task.table = tables[pos].name;
 
                 a_json_task.sql_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + "_query.sql";
-                a_json_task.json_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + ".json";
+                a_json_task.chunk_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + ".chunk";
+                a_json_task.header = true;
 
-                a_merge_task.json_files.append(currDir.absolutePath() + currDir.separator() + tables[pos].name + ".json");
+                a_merge_task.chunk_files.append(a_json_task.chunk_file);
 
 
                 fields.clear();
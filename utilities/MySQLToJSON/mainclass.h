@@ -6,6 +6,10 @@
 #include <QDir>
 #include <QSqlDatabase>
 
+//QMYSQL stores the whole result of a query in the client (mysql_store_result), even for forward only queries,
+//so the tables are split in chunks of up to this number of rows to bound the memory of each worker
+#define CHUNK_ROWS 100000
+
 struct fieldDef
 {
   QString name; //Field Name
@@ -64,9 +68,10 @@ struct taskItem
     QString table;
     int task_type;
     QString sql_file;
-    QString json_file;
-    QStringList json_files;
+    QString chunk_file;
+    QStringList chunk_files;
     QString final_file;
+    bool header = false;
 };
 typedef taskItem TtaskItem;
 
@@ -89,6 +94,7 @@ private:
     void loadTable(QDomNode node);
     void getMultiSelectInfo(QDomNode table, QString table_name, QString &multiSelect_field, QStringList &keys, QString &rel_table, QString &rel_field);
     QStringList get_parts(int total, int parts);
+    int getNumParts(int total);
     QString host;
     QString port;
     QString user;
@@ -0,0 +1,130 @@
+#include "rowwriter.h"
+#include <QVariant>
+#include <QDateTime>
+#include <QSqlField>
+
+rowWriter::rowWriter()
+{
+    numRows = 0;
+}
+
+rowWriter::~rowWriter()
+{
+    if (file.isOpen())
+        file.close();
+}
+
+int rowWriter::open(QString fileName)
+{
+    numRows = 0;
+    names.clear();
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return 1;
+    return 0;
+}
+
+QByteArray rowWriter::jsonString(QString value)
+{
+    QByteArray res;
+    res.append('"');
+    for (int pos = 0; pos < value.length(); pos++)
+    {
+        QChar c = value[pos];
+        switch (c.unicode())
+        {
+        case '"': res.append("\\\""); break;
+        case '\\': res.append("\\\\"); break;
+        case '\n': res.append("\\n"); break;
+        case '\r': res.append("\\r"); break;
+        case '\t': res.append("\\t"); break;
+        case '\b': res.append("\\b"); break;
+        case '\f': res.append("\\f"); break;
+        default:
+            if (c.unicode() < 0x20)
+                res.append(QString("\\u%1").arg(c.unicode(),4,16,QChar('0')).toLatin1());
+            else
+                res.append(QString(c).toUtf8());
+        }
+    }
+    res.append('"');
+    return res;
+}
+
+//Nothing is written. The names are kept in the order of the query because a QJsonObject would sort them
+void rowWriter::writeHeader(const QSqlRecord &record)
+{
+    names.clear();
+    for (int col = 0; col < record.count(); col++)
+        names.append(jsonString(record.fieldName(col)) + ":");
+}
+
+void rowWriter::writeRow(const QSqlRecord &record)
+{
+    if (names.count() != record.count())
+        writeHeader(record);
+    line.clear();
+    if (numRows > 0)
+        line.append(",\n");
+    line.append('{');
+    for (int col = 0; col < record.count(); col++)
+    {
+        if (col > 0)
+            line.append(',');
+        line.append(names[col]);
+        QVariant value = record.value(col);
+        if (record.isNull(col))
+            line.append("\"\"");
+        else
+        {
+            //The decimals come as text with HighPrecision so the type of the column is used
+            switch (record.field(col).type())
+            {
+            case QVariant::Int:
+            case QVariant::UInt:
+            case QVariant::LongLong:
+            case QVariant::ULongLong:
+            case QVariant::Double:
+                line.append(value.toString().toUtf8());
+                break;
+            default:
+                line.append(jsonString(textValue(value)));
+            }
+        }
+    }
+    line.append('}');
+    file.write(line);
+    numRows++;
+}
+
+int rowWriter::rows()
+{
+    return numRows;
+}
+
+//The values are written as MySQL writes them: the dates are not in ISO format and the decimals keep
+//their digits because the queries of the chunks read the numbers with QSql::HighPrecision
+QString rowWriter::textValue(const QVariant &value)
+{
+    switch (value.type())
+    {
+    case QVariant::DateTime:
+        return value.toDateTime().toString("yyyy-MM-dd HH:mm:ss");
+    case QVariant::Date:
+        return value.toDate().toString("yyyy-MM-dd");
+    case QVariant::Time:
+        return value.toTime().toString("HH:mm:ss");
+    default:
+        return value.toString();
+    }
+}
+
+int rowWriter::close()
+{
+    if (!file.isOpen())
+        return 0;
+    file.close();
+    if (file.error() != QFileDevice::NoError)
+        return 1;
+    return 0;
+}
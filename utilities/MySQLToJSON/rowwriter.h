@@ -0,0 +1,29 @@
+#ifndef ROWWRITER_H
+#define ROWWRITER_H
+
+#include <QFile>
+#include <QSqlRecord>
+#include <QVariant>
+
+//Writes the rows of a query result as JSON objects as they are fetched from the server.
+//The objects of a chunk are separated by commas so chunks can be joined into one array
+class rowWriter
+{
+public:
+    rowWriter();
+    ~rowWriter();
+    int open(QString fileName);
+    void writeHeader(const QSqlRecord &record);
+    void writeRow(const QSqlRecord &record);
+    int close();
+    int rows();
+    static QString textValue(const QVariant &value);
+private:
+    QByteArray jsonString(QString value);
+    QFile file;
+    QByteArray line;
+    QList<QByteArray> names;
+    int numRows;
+};
+
+#endif // ROWWRITER_H
@@ -17,6 +17,12 @@ TEMPLATE = app
 INCLUDEPATH += ../../3rdparty
 
 SOURCES += \
-    main.cpp
+    main.cpp \
+    listmutex.cpp \
+    batchqueue.cpp \
+    tablereader.cpp
 
-HEADERS  +=
+HEADERS  += \
+    listmutex.h \
+    batchqueue.h \
+    tablereader.h
@@ -0,0 +1,67 @@
+#include "batchqueue.h"
+
+batchQueue::batchQueue()
+{
+    capacity = 1;
+    readers = 0;
+    isAborted = false;
+}
+
+void batchQueue::setCapacity(int capacity)
+{
+    if (capacity < 1)
+        capacity = 1;
+    this->capacity = capacity;
+}
+
+void batchQueue::setReaders(int readers)
+{
+    this->readers = readers;
+}
+
+//Returns false if the queue was aborted and the reader must stop
+bool batchQueue::push(const TrowBatch &batch)
+{
+    QMutexLocker locker(&mutex);
+    while ((batches.count() >= capacity) && (!isAborted))
+        notFull.wait(&mutex);
+    if (isAborted)
+        return false;
+    batches.append(batch);
+    notEmpty.wakeOne();
+    return true;
+}
+
+//Returns false when all the readers are done and the queue is empty, or if the queue was aborted
+bool batchQueue::pop(TrowBatch &batch)
+{
+    QMutexLocker locker(&mutex);
+    while ((batches.isEmpty()) && (readers > 0) && (!isAborted))
+        notEmpty.wait(&mutex);
+    if ((isAborted) || (batches.isEmpty()))
+        return false;
+    batch = batches.takeFirst();
+    notFull.wakeOne();
+    return true;
+}
+
+void batchQueue::readerDone()
+{
+    QMutexLocker locker(&mutex);
+    readers--;
+    notEmpty.wakeAll();
+}
+
+void batchQueue::abort()
+{
+    QMutexLocker locker(&mutex);
+    isAborted = true;
+    notFull.wakeAll();
+    notEmpty.wakeAll();
+}
+
+bool batchQueue::aborted()
+{
+    QMutexLocker locker(&mutex);
+    return isAborted;
+}
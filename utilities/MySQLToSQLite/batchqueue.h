@@ -0,0 +1,40 @@
+#ifndef BATCHQUEUE_H
+#define BATCHQUEUE_H
+
+#include <QList>
+#include <QVariant>
+#include <QMutex>
+#include <QWaitCondition>
+
+//A group of rows of one table read from MySQL
+struct rowBatch
+{
+    int table; //Index of the table in the list of tables to copy
+    QList<QVariantList> rows;
+};
+typedef rowBatch TrowBatch;
+
+//Bounded queue between the readers and the writer. The readers wait when the queue is full so the
+//memory used does not depend on how much faster MySQL is than SQLite
+class batchQueue
+{
+public:
+    batchQueue();
+    void setCapacity(int capacity);
+    void setReaders(int readers);
+    bool push(const TrowBatch &batch);
+    bool pop(TrowBatch &batch);
+    void readerDone();
+    void abort();
+    bool aborted();
+private:
+    QList<TrowBatch> batches;
+    int capacity;
+    int readers;
+    bool isAborted;
+    QMutex mutex;
+    QWaitCondition notFull;
+    QWaitCondition notEmpty;
+};
+
+#endif // BATCHQUEUE_H
@@ -9,15 +9,20 @@ ListMutex::ListMutex(QObject *parent)
 
 void ListMutex::set_total(int total)
 {
-    this->total = total-1;
+    this->total = total;
+    this->next = 0;
 }
 
+//The tables are given in the order of the list so the lookups are read before the data tables
 int ListMutex::get_index()
 {
     int res = -1;
     mutex.lock();
-    res = total;
-    total = total -1;
+    if (next < total)
+    {
+        res = next;
+        next = next + 1;
+    }
     mutex.unlock();
     return res;
 }
@@ -13,6 +13,7 @@ public:
     int get_index();
 private:
     int total;
+    int next;
     QMutex mutex;
 };
 
@@ -27,12 +27,14 @@ License along with MySQLToSQLite.  If not, see <http://www.gnu.org/licenses/lgpl
 #include <QSqlError>
 #include <QUuid>
 #include <QStringList>
+#include "listmutex.h"
+#include "batchqueue.h"
+#include "tablereader.h"
 
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/xml_parser.hpp>
-#include <boost/foreach.hpp>
-
-namespace pt = boost::property_tree;
+//Rows inserted in SQLite before each commit
+#define ROWS_PER_TRANSACTION 100000
+//Batches of rows that each reader can have waiting for the writer
+#define BATCHES_PER_READER 4
 
 struct tblDef
 {
@@ -281,147 +283,203 @@ void procTables(QDomNode start)
     }
 }
 
-void parseData(QString fileName, QString tableName, QTextStream &out_file)
+//Runs a statement in the SQLite file
+int execLite(QSqlDatabase &dblite, QString sql)
 {
-    pt::ptree tree;
-    pt::read_xml(fileName.toUtf8().constData(), tree);
-    BOOST_FOREACH(boost::property_tree::ptree::value_type const&db, tree.get_child("mysqldump") )
+    QSqlQuery query(dblite);
+    if (!query.exec(sql))
     {
-        const boost::property_tree::ptree & aDatabase = db.second; // value (or a subnode)
-        BOOST_FOREACH(boost::property_tree::ptree::value_type const&ctable, aDatabase.get_child("") )
+        log("Error in SQLite: " + query.lastError().databaseText());
+        log(sql);
+        return 1;
+    }
+    return 0;
+}
+
+//Splits a SQL script into statements. The semicolons inside quotes or inside the BEGIN ... END
+//of a trigger do not end the statement
+QStringList splitScript(QString script)
+{
+    QStringList res;
+    QString statement;
+    bool inQuote = false;
+    QRegExp triggerStart("^CREATE\\s+(TEMP\\s+|TEMPORARY\\s+)?TRIGGER\\b", Qt::CaseInsensitive);
+    QRegExp triggerEnd("\\bEND$", Qt::CaseInsensitive);
+    for (int pos = 0; pos < script.length(); pos++)
+    {
+        QChar c = script.at(pos);
+        statement.append(c);
+        if (c == '\'')
+            inQuote = !inQuote;
+        if ((c == ';') && (!inQuote))
         {
-            const std::string & key = ctable.first.data();
-            if (key == "table_data")
-            {
-                const boost::property_tree::ptree & aTable = ctable.second;
-                BOOST_FOREACH(boost::property_tree::ptree::value_type const&row, aTable.get_child("") )
-                {
-                    const boost::property_tree::ptree & aRow = row.second;
-                    QStringList lst_fields;
-                    QStringList lst_values;
-                    BOOST_FOREACH(boost::property_tree::ptree::value_type const&field, aRow.get_child("") )
-                    {
-                        const std::string & fkey = field.first.data();
-                        if (fkey == "field")
-                        {
-                            const boost::property_tree::ptree & aField = field.second;
-                            std::string fname = aField.get<std::string>("<xmlattr>.name");
-                            std::string fvalue = aField.data();
-                            lst_fields.append(QString::fromStdString(fname));
-                            QString value;
-                            value = QString::fromStdString(fvalue);
-                            value.replace("'","");
-                            lst_values.append("'" + value + "'");
-                        }
-                    }
-                    if (lst_fields.length() > 0)
-                    {
-                        QString sql;
-                        sql = "INSERT INTO " + tableName + " (" + lst_fields.join(",") + ") VALUES (" + lst_values.join(",") + ");\n";
-                        sql = sql.replace("''","null");
-                        out_file << sql;
-                    }
-                }
-            }
+            QString sql = statement.trimmed();
+            sql.chop(1);
+            sql = sql.trimmed();
+            if ((triggerStart.indexIn(sql) == 0) && (triggerEnd.indexIn(sql) < 0))
+                continue;
+            if (!sql.isEmpty())
+                res.append(sql);
+            statement = "";
+        }
+    }
+    if (!statement.trimmed().isEmpty())
+        res.append(statement.trimmed());
+    return res;
+}
+
+//Runs the statements of a SQL file in one transaction
+int loadScript(QSqlDatabase &dblite, QString fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        log("Cannot open " + fileName);
+        return 1;
+    }
+    QStringList statements = splitScript(QString::fromUtf8(file.readAll()));
+    file.close();
+    dblite.transaction();
+    for (int pos = 0; pos < statements.count(); pos++)
+    {
+        if (execLite(dblite, statements[pos]) != 0)
+        {
+            dblite.rollback();
+            return 1;
         }
     }
+    dblite.commit();
+    return 0;
 }
 
-int procData(QString tempDir, QString host, QString user, QString pass, QString schema, QTextStream &out_file, QString tableName)
+//Copies the data with a pipeline. Several readers fetch the tables from MySQL into a bounded queue
+//of row batches while this thread, the only writer SQLite allows, inserts them with a prepared
+//insert per table
+int copyData(QSqlDatabase &dblite, QString host, QString port, QString user, QString pass, QString schema, int workers)
 {
     QStringList ignoreTables;
     ignoreTables << "audit_log";
     ignoreTables << "dict_iso639";
     ignoreTables << "alembic_version";
 
-    bool maria_bd = false;
-    QStringList version_arguments;
-    version_arguments.clear();
-    version_arguments << "--version";
-    QString version_info;
-    QProcess *version_process = new QProcess();
-    version_process->start("mariadb_config", version_arguments);
-    version_process->waitForFinished(-1);    
-    if (version_process->exitCode() == 0)
+    QList< TcopyItem> task_list;
+    for (int pos = 0; pos < lst_tables.count(); pos++)
     {
-        maria_bd = true;
-        version_info = version_process->readAllStandardOutput().replace("\n","");
-    }
-    else
-    {
-        version_process->start("mysql_config", version_arguments);
-        version_process->waitForFinished(-1);
-        if (version_process->exitCode() == 0)
+        if (ignoreTables.indexOf(lst_tables[pos].name) >= 0)
+            continue;
+        TcopyItem a_task;
+        a_task.name = lst_tables[pos].name;
+        QSqlQuery info(dblite);
+        info.exec("PRAGMA table_info(" + a_task.name + ")");
+        //The primary key is the same as in MySQL. pk is the position of the column in the key
+        QMap<int, QString> keys;
+        while (info.next())
         {
-            version_info = version_process->readAllStandardOutput().replace("\n","");            
+            a_task.columns.append(info.value(1).toString());
+            if (info.value(5).toInt() > 0)
+                keys.insert(info.value(5).toInt(), info.value(1).toString());
         }
+        a_task.keys = keys.values();
+        if (a_task.columns.count() == 0)
+        {
+            log("Table " + a_task.name + " does not exist in the SQLite file");
+            return 1;
+        }
+        task_list.append(a_task);
     }
-    if (version_info == "")
-    {
-        log("Unable to detect the version of MySQL");
-        exit(1);
-    }
-    QStringList version_parts = version_info.split(".");
-    int version_number = version_parts[0].toInt();
-
-    QString program = "mysqldump";
-    QStringList arguments;
-    arguments << "--single-transaction";
-    if (maria_bd == false && version_number >= 8)
+    if (task_list.count() == 0)
+        return 0;
+
+    if (workers > task_list.count())
+        workers = task_list.count();
+    if (workers < 1)
+        workers = 1;
+
+    ListMutex mutex;
+    mutex.set_total(task_list.count());
+    batchQueue queue;
+    queue.setCapacity(workers * BATCHES_PER_READER);
+    queue.setReaders(workers);
+    QList< tableReader*> readers;
+    for (int w=1; w <= workers; w++)
     {
-        arguments << "--skip-column-statistics";
-        arguments << "--ssl-mode=DISABLED";
+        tableReader *a_reader = new tableReader();
+        a_reader->setName("Reader" + QString::number(w));
+        a_reader->setParameters(host, port, user, pass, schema);
+        a_reader->setTasks(task_list);
+        a_reader->setMutex(&mutex);
+        a_reader->setQueue(&queue);
+        readers.append(a_reader);
     }
-    arguments << "-h" << host;
-    arguments << "-u" << user;
-    arguments << "--password=" + pass;
-    arguments << "--skip-triggers";
-    arguments << "--no-create-info";
-    arguments << "--xml";
-    for (int pos = 0; pos < ignoreTables.count(); pos++)
-        arguments << "--ignore-table=" + schema + "." + ignoreTables[pos];
-    arguments << schema;
-    arguments << tableName;
-
-    QDir temp_dir(tempDir);
-    if (!temp_dir.exists())
+    for (int w=0; w < readers.count(); w++)
     {
-        log("Temporary directory does not exists");
-        return 1;
+        readers[w]->start();
     }
 
-    QString temp_dump_file = temp_dir.absolutePath() + QDir::separator() + "tempDump.xml";
-    QProcess *myProcess = new QProcess();
-    if (QFile::exists(temp_dump_file))
+    int res = 0;
+    QList< QSqlQuery*> inserts;
+    for (int pos = 0; pos < task_list.count(); pos++)
+        inserts.append(nullptr);
+    qint64 rows = 0;
+    TrowBatch batch;
+    dblite.transaction();
+    while ((res == 0) && (queue.pop(batch)))
     {
-        if (!QFile::remove(temp_dump_file))
+        QSqlQuery *insert = inserts[batch.table];
+        if (insert == nullptr)
         {
-            log("Error removing temporary dump file");
-            return 1;
+            QStringList params;
+            for (int col = 0; col < task_list[batch.table].columns.count(); col++)
+                params.append("?");
+            insert = new QSqlQuery(dblite);
+            inserts[batch.table] = insert;
+            if (!insert->prepare("INSERT INTO " + task_list[batch.table].name + " (" + task_list[batch.table].columns.join(",") + ") VALUES (" + params.join(",") + ")"))
+            {
+                log("Error in SQLite: " + insert->lastError().databaseText());
+                res = 1;
+                break;
+            }
         }
-    }
-    myProcess->setStandardOutputFile(temp_dump_file);
-    myProcess->start(program, arguments);
-    myProcess->waitForFinished(-1);
-    if ((myProcess->exitCode() > 0) || (myProcess->error() == QProcess::FailedToStart))
-    {
-        if (myProcess->error() == QProcess::FailedToStart)
+        for (int row = 0; row < batch.rows.count(); row++)
         {
-            log("Error: Command " +  program + " not found");
-        }
-        else
-        {
-            log("Running MySQLDump returned error");
-            QString serror = myProcess->readAllStandardError();
-            log(serror);
-            log("Running paremeters:" + arguments.join(" "));
+            for (int col = 0; col < batch.rows[row].count(); col++)
+                insert->bindValue(col, batch.rows[row][col]);
+            if (!insert->exec())
+            {
+                log("Error inserting into " + task_list[batch.table].name + ": " + insert->lastError().databaseText());
+                res = 1;
+                break;
+            }
+            rows++;
+            if (rows % ROWS_PER_TRANSACTION == 0)
+            {
+                dblite.commit();
+                dblite.transaction();
+            }
         }
-        return 1;
     }
-    //log("Processing: " + tableName);
-    parseData(temp_dump_file, tableName, out_file);
-
-    return 0;
+    //The readers stop if the writer fails
+    if (res != 0)
+        queue.abort();
+    for (int w=0; w < readers.count(); w++)
+    {
+        readers[w]->wait();
+    }
+    if (queue.aborted())
+        res = 1;
+    for (int w=0; w < readers.count(); w++)
+    {
+        if (readers[w]->status != 0)
+            res = 1;
+        delete readers[w];
+    }
+    for (int pos = 0; pos < inserts.count(); pos++)
+        delete inserts[pos];
+    if (res == 0)
+        dblite.commit();
+    else
+        dblite.rollback();
+    return res;
 }
 
 int main(int argc, char *argv[])
@@ -430,8 +488,7 @@ int main(int argc, char *argv[])
     title = title + "****************************************************************** \n";
     title = title + " * MySQLToSQLite                                                  * \n";
     title = title + " * This tool generates a SQLite file from a MySQL schema.         * \n";
-    title = title + " * The tool relies on MySQLDump, sqlite3 to convert a MySQL       * \n";
-    title = title + " * XML dump file into a sqlite database.                          * \n";
+    title = title + " * The rows are copied directly from MySQL into the SQLite file.  * \n";
     title = title + " * (c) QLands, 2019                                               * \n";
     title = title + " ****************************************************************** \n";
 
@@ -443,9 +500,10 @@ int main(int argc, char *argv[])
     TCLAP::ValueArg<std::string> passArg("p","password","MySQL password",true,"","string");
     TCLAP::ValueArg<std::string> schemaArg("s","schema","MySQL schema",true,"","string");
     TCLAP::ValueArg<std::string> auditArg("a","audit","Input audit file",true,"","string");
-    TCLAP::ValueArg<std::string> tempArg("t","temp","Temporary directory",false,".","string");
+    TCLAP::ValueArg<std::string> tempArg("t","temp","Temporary directory. Not used. Kept for compatibility",false,".","string");
     TCLAP::ValueArg<std::string> createArg("c","create","Create XML file",true,"","string");
     TCLAP::ValueArg<std::string> outputArg("o","output","Ooutput snapshot file",true,"","string");
+    TCLAP::ValueArg<std::string> numWorkers("w","workers","Number of threads reading from MySQL while the SQLite file is written. 1 by default",false,"1","string");
 
 
     cmd.add(hostArg);
@@ -457,6 +515,7 @@ int main(int argc, char *argv[])
     cmd.add(outputArg);
     cmd.add(tempArg);
     cmd.add(createArg);
+    cmd.add(numWorkers);
     //Parsing the command lines
     cmd.parse( argc, argv );
 
@@ -470,8 +529,11 @@ int main(int argc, char *argv[])
     QString schema = QString::fromUtf8(schemaArg.getValue().c_str());
     QString auditFile = QString::fromUtf8(auditArg.getValue().c_str());
     QString outputFile = QString::fromUtf8(outputArg.getValue().c_str());
-    QString tempDir = QString::fromUtf8(tempArg.getValue().c_str());
     QString createXML = QString::fromUtf8(createArg.getValue().c_str());
+    bool ok;
+    int workers = QString::fromUtf8(numWorkers.getValue().c_str()).toInt(&ok);
+    if (!ok)
+        workers = 1;
 
     {
         QSqlDatabase db = QSqlDatabase::addDatabase("QMYSQL","MyDB");
@@ -519,86 +581,69 @@ int main(int argc, char *argv[])
                             procTables(tables.firstChild());
                         }
 
-                        QDir temp_dir(tempDir);
-                        if (!temp_dir.exists())
-                        {
-                            if (!temp_dir.mkdir(temp_dir.absolutePath()))
-                            {
-                                log("Error creating temporary directory");
-                                return 1;
-                            }
-                        }
-                        QString out_sqlite_file;
-                        out_sqlite_file = temp_dir.absolutePath() + QDir::separator() + "sqlite.sql";
-                        QFile file(out_sqlite_file);
-                        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-                            return  1;
-                        QTextStream out(&file);
-                        out.setCodec("UTF-8");
-                        out << "BEGIN;\n";
+                        //The file is built from scratch so there is nothing to roll back if the tool fails.
+                        //The journal and the syncs to disk are turned off while the file is built
+                        execLite(dblite, "PRAGMA journal_mode = OFF");
+                        execLite(dblite, "PRAGMA synchronous = OFF");
+
+                        int res = 0;
+                        dblite.transaction();
                         for (int pos = 0; pos < lst_tables.count(); pos++)
                         {
-                            out << lst_tables[pos].create + "\n";
-                            for (int idx=0; idx < lst_tables[pos].indexes.count(); idx++)
+                            if (execLite(dblite, lst_tables[pos].create) != 0)
                             {
-                                out << lst_tables[pos].indexes[idx] + "\n";
+                                res = 1;
+                                break;
                             }
                         }
-                        out << "\n";
-                        log("Processing data....");
-                        for (int pos = 0; pos < lst_tables.count(); pos++)
+                        if (res == 0)
+                            dblite.commit();
+                        else
+                            dblite.rollback();
+
+                        if (res == 0)
                         {
-                            procData(tempDir, host, user, pass, schema, out, lst_tables[pos].name);
+                            log("Processing data....");
+                            res = copyData(dblite, host, port, user, pass, schema, workers);
                         }
-                        out << "COMMIT;\n";
-                        file.close();
-
-                        QString program;
-                        QStringList arguments;
-                        program = "sqlite3";
-                        arguments << "-bail";
-                        arguments << dblite.databaseName();
-                        dblite.close();
-                        QProcess *myProcess = new QProcess();
-                        myProcess->setStandardInputFile(out_sqlite_file);
-                        myProcess->start(program, arguments);
-                        myProcess->waitForFinished(-1);
-                        if ((myProcess->exitCode() > 0) || (myProcess->error() == QProcess::FailedToStart))
+                        //The indexes are created once the data is loaded so the inserts do not have to update them
+                        if (res == 0)
                         {
-                            if (myProcess->error() == QProcess::FailedToStart)
+                            log("Creating indexes");
+                            dblite.transaction();
+                            for (int pos = 0; pos < lst_tables.count(); pos++)
                             {
-                                log("Error: Command " +  program + " not found");
+                                for (int idx=0; idx < lst_tables[pos].indexes.count(); idx++)
+                                {
+                                    if (execLite(dblite, lst_tables[pos].indexes[idx]) != 0)
+                                    {
+                                        res = 1;
+                                        break;
+                                    }
+                                }
+                                if (res != 0)
+                                    break;
                             }
+                            if (res == 0)
+                                dblite.commit();
                             else
-                            {
-                                log("Running Sqlite3 returned error");
-                                QString serror = myProcess->readAllStandardError();
-                                log(serror);
-                                log("Running paremeters:" + arguments.join(" "));
-                            }
-                            return 1;
+                                dblite.rollback();
                         }
-
-                        log("Loading audit triggers");
-                        myProcess->setStandardInputFile(auditFile);
-                        myProcess->start(program, arguments);
-                        myProcess->waitForFinished(-1);
-                        if ((myProcess->exitCode() > 0) || (myProcess->error() == QProcess::FailedToStart))
+                        if (res == 0)
                         {
-                            if (myProcess->error() == QProcess::FailedToStart)
-                            {
-                                log("Error: Command " +  program + " not found");
-                            }
-                            else
-                            {
-                                log("Running Sqlite3 returned error");
-                                QString serror = myProcess->readAllStandardError();
-                                log(serror);
-                                log("Running paremeters:" + arguments.join(" "));
-                            }
+                            log("Loading audit triggers");
+                            res = loadScript(dblite, auditFile);
+                        }
+                        db.close();
+                        if (res != 0)
+                        {
+                            dblite.close();
+                            QFile::remove(outputFile);
                             return 1;
                         }
-
+                        execLite(dblite, "PRAGMA synchronous = FULL");
+                        execLite(dblite, "PRAGMA journal_mode = DELETE");
+                        dblite.close();
                         log("SQLite created successfully");
 
                     }
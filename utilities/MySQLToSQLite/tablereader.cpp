@@ -0,0 +1,220 @@
+#include "tablereader.h"
+#include <QDateTime>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSqlField>
+#include <QSqlDriver>
+
+//Rows in each batch given to the writer
+#define ROWS_PER_BATCH 1000
+//Rows read from MySQL in each query. QMYSQL stores the whole result of a query in memory
+#define ROWS_PER_PAGE 10000
+
+tableReader::tableReader(QObject *parent)
+    : QThread{parent}
+{
+
+}
+
+void tableReader::setParameters(QString host, QString port, QString user, QString pass, QString schema)
+{
+    this->host = host;
+    this->port = port;
+    this->user = user;
+    this->pass = pass;
+    this->schema = schema;
+}
+
+void tableReader::setName(QString name)
+{
+    this->name = name;
+}
+
+void tableReader::setTasks(QList< TcopyItem> task_list)
+{
+    this->task_list = task_list;
+}
+
+void tableReader::setMutex(ListMutex *mutex)
+{
+    this->mutex = mutex;
+}
+
+void tableReader::setQueue(batchQueue *queue)
+{
+    this->queue = queue;
+}
+
+void tableReader::log(QString message)
+{
+    QString temp;
+    temp = message + "\n";
+    printf("%s", temp.toUtf8().data());
+}
+
+//A connection can only be used by the thread that created it
+int tableReader::openConnection(QSqlDatabase &db, QString connection_name)
+{
+    db = QSqlDatabase::addDatabase("QMYSQL",connection_name);
+    db.setHostName(host);
+    db.setPort(port.toInt());
+    db.setDatabaseName(schema);
+    db.setUserName(user);
+    db.setPassword(pass);
+    if (!db.open())
+    {
+        log(name + " - Error while conneting to MySQL: " + db.lastError().databaseText());
+        return 1;
+    }
+    QSqlQuery qry(db);
+    qry.exec("SET NAMES utf8mb4");
+    return 0;
+}
+
+//The values are stored as mysqldump wrote them so the snapshots do not change. Empty values are stored as null
+static QVariant liteValue(const QVariant &value)
+{
+    if (value.isNull())
+        return QVariant(QVariant::String);
+    switch (value.type())
+    {
+    case QVariant::DateTime:
+        return value.toDateTime().toString("yyyy-MM-dd HH:mm:ss");
+    case QVariant::Date:
+        return value.toDate().toString("yyyy-MM-dd");
+    case QVariant::Time:
+        return value.toTime().toString("HH:mm:ss");
+    case QVariant::String:
+        if (value.toString().isEmpty())
+            return QVariant(QVariant::String);
+        return value;
+    default:
+        return value;
+    }
+}
+
+//The driver stores the whole result of a query in memory, so the table is read in pages of ROWS_PER_PAGE
+//rows ordered by its primary key (keyset pagination) and the queue of batches is bounded. The memory does
+//not depend on the size of the table. The pages are read in one snapshot so together they are the table
+//as it was when the copy started
+int tableReader::readTable(QSqlDatabase &db, int index)
+{
+    QSqlQuery query(db);
+    if (!query.exec("START TRANSACTION WITH CONSISTENT SNAPSHOT"))
+    {
+        log(name + " - Error reading " + task_list[index].name + ": " + query.lastError().databaseText());
+        return 1;
+    }
+    int result = readPages(db, index);
+    query.exec("COMMIT");
+    return result;
+}
+
+//A table without primary key is ordered by all its columns and paged with an offset. Rows that are
+//equal in all columns can come in any order because they are the same row for the copy
+int tableReader::readPages(QSqlDatabase &db, int index)
+{
+    const TcopyItem &task = task_list[index];
+    int columns = task.columns.count();
+    QList<int> keys;
+    for (int k = 0; k < task.keys.count(); k++)
+        keys.append(task.columns.indexOf(task.keys[k]));
+    QString order = task.columns.join(",");
+    if (keys.count() > 0)
+        order = task.keys.join(",");
+    QString condition = "";
+    int offset = 0;
+    TrowBatch batch;
+    batch.table = index;
+    while (true)
+    {
+        QString sql = "SELECT " + task.columns.join(",") + " FROM " + task.name;
+        if (condition != "")
+            sql = sql + " WHERE (" + task.keys.join(",") + ") > (" + condition + ")";
+        sql = sql + " ORDER BY " + order + " LIMIT ";
+        if (keys.count() == 0)
+            sql = sql + QString::number(offset) + ",";
+        sql = sql + QString::number(ROWS_PER_PAGE);
+
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        if (!query.exec(sql))
+        {
+            log(name + " - Error reading " + task.name + ": " + query.lastError().databaseText());
+            return 1;
+        }
+        int rows = 0;
+        QVariantList last;
+        for (int k = 0; k < keys.count(); k++)
+            last.append(QVariant());
+        while (query.next())
+        {
+            QVariantList row;
+            row.reserve(columns);
+            for (int col = 0; col < columns; col++)
+                row.append(liteValue(query.value(col)));
+            batch.rows.append(row);
+            rows++;
+            if (batch.rows.count() >= ROWS_PER_BATCH)
+            {
+                if (!queue->push(batch))
+                    return 1;
+                batch.rows.clear();
+            }
+            for (int k = 0; k < keys.count(); k++)
+                last[k] = query.value(keys[k]);
+        }
+        if (query.lastError().isValid())
+        {
+            log(name + " - Error reading " + task.name + ": " + query.lastError().databaseText());
+            return 1;
+        }
+        if (rows < ROWS_PER_PAGE)
+            break;
+        //The next page starts after the key of the last row
+        QStringList values;
+        for (int k = 0; k < keys.count(); k++)
+        {
+            QSqlField field(task.keys[k], last[k].type());
+            field.setValue(last[k]);
+            values.append(db.driver()->formatValue(field));
+        }
+        condition = values.join(",");
+        offset = offset + rows;
+    }
+    if (batch.rows.count() > 0)
+    {
+        if (!queue->push(batch))
+            return 1;
+    }
+    return 0;
+}
+
+void tableReader::run()
+{
+    QSqlDatabase db;
+    this->status = 0;
+    if (openConnection(db, name) != 0)
+        this->status = 1;
+
+    int index = -1;
+    if (this->status == 0)
+        index = mutex->get_index();
+    while (index >= 0)
+    {
+        if (readTable(db, index) != 0)
+        {
+            this->status = 1;
+            break;
+        }
+        index = mutex->get_index();
+    }
+    //The writer stops if a reader fails
+    if (this->status != 0)
+        queue->abort();
+    queue->readerDone();
+
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(name);
+}
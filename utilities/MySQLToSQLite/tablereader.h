@@ -0,0 +1,48 @@
+#ifndef TABLEREADER_H
+#define TABLEREADER_H
+
+#include <QThread>
+#include <QSqlDatabase>
+#include <QStringList>
+#include "listmutex.h"
+#include "batchqueue.h"
+
+//A table to copy, the columns it has in the SQLite file and the columns of its primary key
+struct copyItem
+{
+    QString name;
+    QStringList columns;
+    QStringList keys;
+};
+typedef copyItem TcopyItem;
+
+//Reads whole tables from MySQL with its own connection, a page at a time, and hands the rows to the writer in batches
+class tableReader : public QThread
+{
+    Q_OBJECT
+public:
+    explicit tableReader(QObject *parent = nullptr);
+    void run();
+    void setTasks(QList< TcopyItem> task_list);
+    void setMutex(ListMutex *mutex);
+    void setQueue(batchQueue *queue);
+    void setName(QString name);
+    void setParameters(QString host, QString port, QString user, QString pass, QString schema);
+    int status;
+private:
+    void log(QString message);
+    int openConnection(QSqlDatabase &db, QString connection_name);
+    int readTable(QSqlDatabase &db, int index);
+    int readPages(QSqlDatabase &db, int index);
+    QList< TcopyItem> task_list;
+    ListMutex *mutex;
+    batchQueue *queue;
+    QString host;
+    QString port;
+    QString pass;
+    QString user;
+    QString schema;
+    QString name;
+};
+
+#endif // TABLEREADER_H
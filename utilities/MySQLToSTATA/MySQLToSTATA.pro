@@ -1,5 +1,5 @@
 QT -= gui
-QT += core xml
+QT += core xml sql
 
 CONFIG += console
 CONFIG -= app_bundle
@@ -19,7 +19,13 @@ DEFINES += QT_DEPRECATED_WARNINGS
 unix:INCLUDEPATH += ../../3rdparty
 
 SOURCES += main.cpp \
-    mainclass.cpp
+    mainclass.cpp \
+    dtawriter.cpp \
+    listmutex.cpp \
+    tableworker.cpp
 
 HEADERS += \
-    mainclass.h
+    mainclass.h \
+    dtawriter.h \
+    listmutex.h \
+    tableworker.h
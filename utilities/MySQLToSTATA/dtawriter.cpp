@@ -0,0 +1,518 @@
+#include "dtawriter.h"
+#include <QDate>
+#include <QDateTime>
+#include <QLocale>
+#include <QVariant>
+#include <QRegExp>
+#include <cstring>
+
+//The file is written with the least significant byte first (LSF)
+static void putU8(QByteArray &data, quint8 value)
+{
+    data.append(char(value));
+}
+
+static void putU16(QByteArray &data, quint16 value)
+{
+    data.append(char(value & 0xFF));
+    data.append(char((value >> 8) & 0xFF));
+}
+
+static void putU32(QByteArray &data, quint32 value)
+{
+    for (int pos = 0; pos < 4; pos++)
+        data.append(char((value >> (8 * pos)) & 0xFF));
+}
+
+static void putU64(QByteArray &data, quint64 value)
+{
+    for (int pos = 0; pos < 8; pos++)
+        data.append(char((value >> (8 * pos)) & 0xFF));
+}
+
+//Cuts a UTF-8 text to a number of bytes without breaking a character
+static QByteArray utf8Left(QByteArray text, int size)
+{
+    if (text.size() <= size)
+        return text;
+    int cut = size;
+    while ((cut > 0) && ((static_cast<quint8>(text.at(cut)) & 0xC0) == 0x80))
+        cut--;
+    return text.left(cut);
+}
+
+//Writes a text in a field of fixed size. The field always ends with at least one null
+static void putFixed(QByteArray &data, QString value, int size)
+{
+    QByteArray text = utf8Left(value.toUtf8(), size - 1);
+    data.append(text);
+    data.append(QByteArray(size - text.size(), '\0'));
+}
+
+dtaWriter::dtaWriter()
+{
+    numRows = 0;
+    rowsPos = 0;
+    mapPos = 0;
+    failed = false;
+}
+
+dtaWriter::~dtaWriter()
+{
+    if (file.isOpen())
+        file.close();
+    if (strlFile.isOpen())
+        strlFile.close();
+}
+
+void dtaWriter::setLabel(QString label)
+{
+    this->label = label;
+}
+
+qint64 dtaWriter::rows()
+{
+    return numRows;
+}
+
+//Stata names have up to 32 letters, digits or underscores and cannot start with a digit
+QString dtaWriter::validName(QString name, QStringList &used)
+{
+    static const QStringList reserved = QStringList() << "_all" << "_b" << "byte" << "_coef" << "_cons" << "double" << "float" << "if" << "in" << "int" << "long" << "_n" << "_N" << "_pi" << "_pred" << "_rc" << "_skip" << "strL" << "using" << "with";
+    QString res;
+    for (int pos = 0; pos < name.length(); pos++)
+    {
+        ushort c = name.at(pos).unicode();
+        if (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) || (c == '_'))
+            res.append(name.at(pos));
+        else
+            res.append('_');
+    }
+    if ((res.isEmpty()) || (res.at(0).isDigit()))
+        res = "_" + res;
+    res = res.left(32);
+    QString base = res;
+    int index = 1;
+    while ((used.contains(res)) || (reserved.contains(res)) || (QRegExp("str[0-9]+").exactMatch(res)))
+    {
+        QString suffix = "_" + QString::number(index);
+        res = base.left(32 - suffix.length()) + suffix;
+        index++;
+    }
+    used.append(res);
+    return res;
+}
+
+//Returns the name of the value label in the file. Only integer values can have labels
+QString dtaWriter::addValueLabel(QString name, QMap<int, QString> labels)
+{
+    QString res = validName(name, labelNames);
+    valueLabels.insert(res, labels);
+    return res;
+}
+
+void dtaWriter::addNumber(QString name, QString label, int type, QString valueLabel)
+{
+    TdtaVariable variable;
+    variable.name = validName(name, names);
+    variable.label = label;
+    variable.valueLabel = valueLabel;
+    variable.kind = 0;
+    variable.type = type;
+    variable.width = 8;
+    if (type == dtaByte)
+        variable.width = 1;
+    if (type == dtaInt)
+        variable.width = 2;
+    if ((type == dtaLong) || (type == dtaFloat))
+        variable.width = 4;
+    variables.append(variable);
+}
+
+//Dates are days since 01jan1960 (%td). Dates with time are milliseconds since 01jan1960 00:00 (%tc)
+void dtaWriter::addDate(QString name, QString label, bool withTime)
+{
+    TdtaVariable variable;
+    variable.name = validName(name, names);
+    variable.label = label;
+    if (withTime)
+    {
+        variable.kind = 2;
+        variable.type = dtaDouble;
+        variable.width = 8;
+    }
+    else
+    {
+        variable.kind = 1;
+        variable.type = dtaLong;
+        variable.width = 4;
+    }
+    variables.append(variable);
+}
+
+//Strings of up to 2045 bytes have a fixed width. Longer ones are stored as strL
+void dtaWriter::addString(QString name, QString label, int width)
+{
+    TdtaVariable variable;
+    variable.name = validName(name, names);
+    variable.label = label;
+    variable.kind = 3;
+    if (width < 1)
+        width = 1;
+    if (width <= 2045)
+    {
+        variable.type = width;
+        variable.width = width;
+    }
+    else
+    {
+        variable.type = dtaStrL;
+        variable.width = 8;
+    }
+    variables.append(variable);
+}
+
+int dtaWriter::open(QString fileName, QString strlFile)
+{
+    numRows = 0;
+    failed = false;
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return 1;
+    this->strlFile.setFileName(strlFile);
+    if (!this->strlFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return 1;
+
+    QByteArray data;
+    map.clear();
+    map.append(0);
+    data.append("<stata_dta><header><release>118</release><byteorder>LSF</byteorder><K>");
+    putU16(data, variables.count());
+    data.append("</K><N>");
+    rowsPos = data.size();
+    putU64(data, 0);
+    data.append("</N><label>");
+    QByteArray text = utf8Left(label.left(80).toUtf8(), 320);
+    putU16(data, text.size());
+    data.append(text);
+    data.append("</label><timestamp>");
+    QByteArray stamp = QLocale::c().toString(QDateTime::currentDateTime(), "dd MMM yyyy hh:mm").toLatin1();
+    putU8(data, stamp.size());
+    data.append(stamp);
+    data.append("</timestamp></header>");
+
+    map.append(data.size());
+    data.append("<map>");
+    mapPos = data.size();
+    for (int pos = 0; pos < 14; pos++)
+        putU64(data, 0);
+    data.append("</map>");
+
+    map.append(data.size());
+    data.append("<variable_types>");
+    for (int var = 0; var < variables.count(); var++)
+        putU16(data, variables[var].type);
+    data.append("</variable_types>");
+
+    map.append(data.size());
+    data.append("<varnames>");
+    for (int var = 0; var < variables.count(); var++)
+        putFixed(data, variables[var].name, 129);
+    data.append("</varnames>");
+
+    map.append(data.size());
+    data.append("<sortlist>");
+    for (int var = 0; var <= variables.count(); var++)
+        putU16(data, 0);
+    data.append("</sortlist>");
+
+    map.append(data.size());
+    data.append("<formats>");
+    for (int var = 0; var < variables.count(); var++)
+    {
+        QString format;
+        switch (variables[var].type)
+        {
+        case dtaByte:
+        case dtaInt:
+            format = "%8.0g";
+            break;
+        case dtaLong:
+            format = "%12.0g";
+            break;
+        case dtaFloat:
+            format = "%9.0g";
+            break;
+        case dtaDouble:
+            format = "%10.0g";
+            break;
+        case dtaStrL:
+            format = "%9s";
+            break;
+        default:
+            format = "%-" + QString::number(variables[var].width) + "s";
+        }
+        if (variables[var].kind == 1)
+            format = "%td";
+        if (variables[var].kind == 2)
+            format = "%tc";
+        putFixed(data, format, 57);
+    }
+    data.append("</formats>");
+
+    map.append(data.size());
+    data.append("<value_label_names>");
+    for (int var = 0; var < variables.count(); var++)
+        putFixed(data, variables[var].valueLabel, 129);
+    data.append("</value_label_names>");
+
+    map.append(data.size());
+    data.append("<variable_labels>");
+    for (int var = 0; var < variables.count(); var++)
+        putFixed(data, variables[var].label.left(80), 321);
+    data.append("</variable_labels>");
+
+    map.append(data.size());
+    data.append("<characteristics></characteristics>");
+
+    map.append(data.size());
+    data.append("<data>");
+    if (file.write(data) < 0)
+        return 1;
+    return 0;
+}
+
+//Empty values and values that are not numbers are written as missing (.)
+void dtaWriter::writeNumber(int var, const QVariant &value)
+{
+    int type = variables[var].type;
+    bool ok = false;
+    QString text;
+    if (!value.isNull())
+        text = value.toString().trimmed();
+    if ((type == dtaDouble) || (type == dtaFloat))
+    {
+        double number = 0;
+        if (text != "")
+            number = text.toDouble(&ok);
+        if (type == dtaDouble)
+        {
+            quint64 bits = Q_UINT64_C(0x7fe0000000000000);
+            if (ok)
+                std::memcpy(&bits, &number, 8);
+            putU64(row, bits);
+        }
+        else
+        {
+            quint32 bits = 0x7f000000;
+            float small = static_cast<float>(number);
+            if (ok)
+                std::memcpy(&bits, &small, 4);
+            putU32(row, bits);
+        }
+        return;
+    }
+    qint64 number = 0;
+    if (text != "")
+    {
+        number = text.toLongLong(&ok);
+        if (!ok)
+            number = qRound64(text.toDouble(&ok));
+    }
+    if (type == dtaByte)
+    {
+        if ((!ok) || (number < -127) || (number > 100))
+            number = 101;
+        putU8(row, static_cast<quint8>(static_cast<qint8>(number)));
+        return;
+    }
+    if (type == dtaInt)
+    {
+        if ((!ok) || (number < -32767) || (number > 32740))
+            number = 32741;
+        putU16(row, static_cast<quint16>(static_cast<qint16>(number)));
+        return;
+    }
+    if ((!ok) || (number < -2147483647LL) || (number > 2147483620LL))
+        number = 2147483621LL;
+    putU32(row, static_cast<quint32>(static_cast<qint32>(number)));
+}
+
+void dtaWriter::writeDate(int var, const QVariant &value)
+{
+    static const qint64 base = QDate(1960,1,1).toJulianDay();
+    QDate date;
+    QTime time(0,0);
+    if (!value.isNull())
+    {
+        if (value.type() == QVariant::DateTime)
+        {
+            date = value.toDateTime().date();
+            time = value.toDateTime().time();
+        }
+        else if (value.type() == QVariant::Date)
+            date = value.toDate();
+        else
+        {
+            QString text = value.toString().trimmed().replace(" ","T");
+            QDateTime date_time = QDateTime::fromString(text, Qt::ISODate);
+            if (date_time.isValid())
+            {
+                date = date_time.date();
+                time = date_time.time();
+            }
+            else
+                date = QDate::fromString(text.left(10), Qt::ISODate);
+        }
+    }
+    if (!time.isValid())
+        time = QTime(0,0);
+    if (variables[var].kind == 2)
+    {
+        quint64 bits = Q_UINT64_C(0x7fe0000000000000);
+        if (date.isValid())
+        {
+            double number = static_cast<double>(date.toJulianDay() - base) * 86400000.0 + time.msecsSinceStartOfDay();
+            std::memcpy(&bits, &number, 8);
+        }
+        putU64(row, bits);
+        return;
+    }
+    qint64 days = 2147483621LL;
+    if (date.isValid())
+        days = date.toJulianDay() - base;
+    putU32(row, static_cast<quint32>(static_cast<qint32>(days)));
+}
+
+//A strL is written as (v,o): the variable in the first 2 bytes and the observation in the other 6.
+//Its content goes to the strls section as a GSO with the same (v,o)
+void dtaWriter::writeString(int var, const QVariant &value)
+{
+    QByteArray text;
+    if (!value.isNull())
+        text = value.toString().toUtf8();
+    if (variables[var].type == dtaStrL)
+    {
+        if (text.isEmpty())
+        {
+            putU64(row, 0);
+            return;
+        }
+        putU64(row, static_cast<quint64>(var + 1) | (static_cast<quint64>(numRows + 1) << 16));
+        QByteArray gso = "GSO";
+        putU32(gso, var + 1);
+        putU64(gso, numRows + 1);
+        putU8(gso, 130);
+        putU32(gso, text.size() + 1);
+        gso.append(text);
+        gso.append('\0');
+        if (strlFile.write(gso) < 0)
+            failed = true;
+        return;
+    }
+    int width = variables[var].width;
+    text = utf8Left(text, width);
+    row.append(text);
+    row.append(QByteArray(width - text.size(), '\0'));
+}
+
+//The values of the record must come in the order of the variables
+void dtaWriter::writeRow(const QSqlRecord &record)
+{
+    row.clear();
+    for (int var = 0; var < variables.count(); var++)
+    {
+        QVariant value;
+        if ((var < record.count()) && (!record.isNull(var)))
+            value = record.value(var);
+        if (variables[var].kind == 0)
+            writeNumber(var, value);
+        else if (variables[var].kind == 3)
+            writeString(var, value);
+        else
+            writeDate(var, value);
+    }
+    if (file.write(row) < 0)
+        failed = true;
+    numRows++;
+}
+
+//Writes the long strings, the value labels and the map and sets the number of observations
+int dtaWriter::close()
+{
+    file.write("</data>");
+
+    map.append(file.pos());
+    file.write("<strls>");
+    QString strlName = strlFile.fileName();
+    strlFile.close();
+    if (strlFile.error() != QFileDevice::NoError)
+        failed = true;
+    QFile strls(strlName);
+    if (strls.open(QIODevice::ReadOnly))
+    {
+        while (!strls.atEnd())
+        {
+            if (file.write(strls.read(1048576)) < 0)
+                failed = true;
+        }
+        strls.close();
+        strls.remove();
+    }
+    else
+        failed = true;
+    file.write("</strls>");
+
+    map.append(file.pos());
+    file.write("<value_labels>");
+    QMapIterator<QString, QMap<int, QString> > labels(valueLabels);
+    while (labels.hasNext())
+    {
+        labels.next();
+        QByteArray offsets;
+        QByteArray values;
+        QByteArray text;
+        QMapIterator<int, QString> entry(labels.value());
+        while (entry.hasNext())
+        {
+            entry.next();
+            putU32(offsets, text.size());
+            putU32(values, static_cast<quint32>(entry.key()));
+            text.append(utf8Left(entry.value().toUtf8(), 32000));
+            text.append('\0');
+        }
+        QByteArray table;
+        putU32(table, labels.value().count());
+        putU32(table, text.size());
+        table.append(offsets);
+        table.append(values);
+        table.append(text);
+
+        QByteArray data = "<lbl>";
+        putU32(data, table.size());
+        putFixed(data, labels.key(), 129);
+        data.append(QByteArray(3, '\0'));
+        data.append(table);
+        data.append("</lbl>");
+        file.write(data);
+    }
+    file.write("</value_labels>");
+
+    map.append(file.pos());
+    file.write("</stata_dta>");
+    map.append(file.pos());
+
+    QByteArray data;
+    putU64(data, numRows);
+    file.seek(rowsPos);
+    file.write(data);
+    data.clear();
+    for (int pos = 0; pos < map.count(); pos++)
+        putU64(data, map[pos]);
+    file.seek(mapPos);
+    file.write(data);
+    file.close();
+    if ((failed) || (file.error() != QFileDevice::NoError))
+        return 1;
+    return 0;
+}
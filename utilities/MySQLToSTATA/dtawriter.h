@@ -0,0 +1,61 @@
+#ifndef DTAWRITER_H
+#define DTAWRITER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QMap>
+#include <QFile>
+#include <QSqlRecord>
+
+//A variable of the .dta file
+struct dtaVariable
+{
+    QString name;
+    QString label;
+    QString valueLabel; //Value label of the variable. Empty if none
+    int kind = 0; //0=Number, 1=Date, 2=Date and time, 3=String
+    int type = 0; //Storage type in the file
+    int width = 0; //Bytes of the variable in each observation
+};
+typedef dtaVariable TdtaVariable;
+
+//Writes a Stata 118 .dta file (Stata 14 and later) as the rows are fetched. The number of observations
+//and the map of the file are written at the end once they are known. The long strings (strL) go to a
+//temporary file while the rows are written and are copied after the data
+class dtaWriter
+{
+public:
+    enum storageType { dtaStrL = 32768, dtaDouble = 65526, dtaFloat = 65527, dtaLong = 65528, dtaInt = 65529, dtaByte = 65530 };
+    dtaWriter();
+    ~dtaWriter();
+    void setLabel(QString label);
+    QString addValueLabel(QString name, QMap<int, QString> labels);
+    void addNumber(QString name, QString label, int type, QString valueLabel = "");
+    void addDate(QString name, QString label, bool withTime);
+    void addString(QString name, QString label, int width);
+    int open(QString fileName, QString strlFile);
+    void writeRow(const QSqlRecord &record);
+    int close();
+    qint64 rows();
+private:
+    QString validName(QString name, QStringList &used);
+    void writeNumber(int var, const QVariant &value);
+    void writeDate(int var, const QVariant &value);
+    void writeString(int var, const QVariant &value);
+    QFile file;
+    QFile strlFile;
+    QString label;
+    QList<TdtaVariable> variables;
+    QStringList names;
+    QStringList labelNames;
+    QMap<QString, QMap<int, QString> > valueLabels;
+    QByteArray row;
+    qint64 numRows;
+    qint64 rowsPos;
+    qint64 mapPos;
+    QList<qint64> map;
+    bool failed;
+};
+
+#endif // DTAWRITER_H
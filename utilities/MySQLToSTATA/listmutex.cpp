@@ -0,0 +1,37 @@
+#include "listmutex.h"
+
+
+ListMutex::ListMutex(QObject *parent)
+    : QObject{parent}
+{
+
+}
+
+void ListMutex::set_total(int total)
+{
+    this->total = total;
+    this->next = 0;
+    this->aborted = false;
+}
+
+//The tables are given in the order of the list, largest first
+int ListMutex::get_index()
+{
+    int res = -1;
+    mutex.lock();
+    if ((!aborted) && (next < total))
+    {
+        res = next;
+        next = next + 1;
+    }
+    mutex.unlock();
+    return res;
+}
+
+//When a table fails the other workers do not start more tables
+void ListMutex::abort()
+{
+    mutex.lock();
+    aborted = true;
+    mutex.unlock();
+}
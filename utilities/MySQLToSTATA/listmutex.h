@@ -0,0 +1,22 @@
+#ifndef LISTMUTEX_H
+#define LISTMUTEX_H
+
+#include <QObject>
+#include <QMutex>
+
+class ListMutex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ListMutex(QObject *parent = nullptr);
+    void set_total(int total);
+    int get_index();
+    void abort();
+private:
+    int total;
+    int next;
+    bool aborted;
+    QMutex mutex;
+};
+
+#endif // LISTMUTEX_H
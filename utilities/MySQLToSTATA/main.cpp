@@ -42,9 +42,9 @@ int main(int argc, char *argv[])
     QString title;
     title = title + " *********************************************************************** \n";
     title = title + " * MySQLToSTATA                                                        * \n";
-    title = title + " * This tool extracts data from a MySQL Database into tab files with   * \n";
-    title = title + " * a companion STATA dictionary file.                                  * \n";
-    title = title + " * Each table will create a new TAB file and a DCF file.               * \n";
+    title = title + " * This tool extracts data from a MySQL Database into STATA files.     * \n";
+    title = title + " * Each table will create a new .dta file (Stata 14 and later) with    * \n";
+    title = title + " * variable labels and the lookup values as value labels.              * \n";
     title = title + " * The tool requires the create.xml file created by JXFormToMySQL to   * \n";
     title = title + " * determine the type of data and whether a field or a table should be * \n";
     title = title + " * exported due to the sensitivity of its information.                 * \n";
@@ -63,6 +63,7 @@ int main(int argc, char *argv[])
     TCLAP::ValueArg<std::string> firstArg("f","firstsheetname","Name for the first sheet",false,"","string");
     TCLAP::ValueArg<std::string> encryptArg("e","encrypt","32 char hex encryption key. Auto generate if empty",false,"","string");
     TCLAP::ValueArg<std::string> resolveArg("r","resolve","Resolve lookup values: 1=Codes only (default), 2=Descriptions, 3=Codes and descriptions",false,"1","string");
+    TCLAP::ValueArg<std::string> numWorkers("w","workers","Number of workers. Each exports one table at a time. 1 by default",false,"1","string");
     TCLAP::SwitchArg lookupSwitch("l","includelookups","Include lookup tables. False by default", cmd, false);
     TCLAP::SwitchArg mselSwitch("m","includemultiselects","Include multi-select tables as sheets. False by default", cmd, false);    
     TCLAP::SwitchArg protectSwitch("c","protect","Protect sensitive fields. False by default", cmd, false);
@@ -78,6 +79,7 @@ int main(int argc, char *argv[])
     cmd.add(firstArg);
     cmd.add(encryptArg);
     cmd.add(resolveArg);
+    cmd.add(numWorkers);
     //Parsing the command lines
     cmd.parse( argc, argv );
 
@@ -103,6 +105,10 @@ int main(int argc, char *argv[])
     QString firstSheetName = QString::fromUtf8(firstArg.getValue().c_str());
     QString encryption_key = QString::fromUtf8(encryptArg.getValue().c_str());
     QString resolve_type = QString::fromUtf8(resolveArg.getValue().c_str());
+    bool ok;
+    int workers = QString::fromUtf8(numWorkers.getValue().c_str()).toInt(&ok);
+    if (!ok)
+        workers = 1;
     if (encryption_key == "")
     {
         QTime time = QTime::currentTime();
@@ -111,7 +117,7 @@ int main(int argc, char *argv[])
     }
 
     mainClass *task = new mainClass(&app);
-    task->setParameters(host,port,user,pass,schema,createXML,outputFile,protectSensitive,tmpDir, includeLookUps, includeMSels, firstSheetName, encryption_key, resolve_type);
+    task->setParameters(host,port,user,pass,schema,createXML,outputFile,protectSensitive,tmpDir, includeLookUps, includeMSels, firstSheetName, encryption_key, resolve_type, workers);
     QObject::connect(task, SIGNAL(finished()), &app, SLOT(quit()));
     QTimer::singleShot(0, task, SLOT(run()));
     app.exec();
@@ -4,7 +4,8 @@
 #include <QDomDocument>
 #include <QDomElement>
 #include <QDomNode>
-#include <QProcess>
+#include <QSqlQuery>
+#include <QSqlError>
 #include <QChar>
 #include <QTime>
 #include <boost/property_tree/xml_parser.hpp>
@@ -12,10 +13,9 @@
 #include <boost/foreach.hpp>
 #include <QDebug>
 #include <QUuid>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
-#include <QRegExp>
+#include <algorithm>
+#include "tableworker.h"
+#include "listmutex.h"
 
 namespace pt = boost::property_tree;
 
@@ -32,7 +32,7 @@ void mainClass::log(QString message)
     printf("%s", temp.toUtf8().data());
 }
 
-void mainClass::setParameters(QString host, QString port, QString user, QString pass, QString schema, QString createXML, QString outputDir, bool protectSensitive, QString tempDir, bool incLookups, bool incmsels, QString firstSheetName, QString encryption_key, QString resolve_type)
+void mainClass::setParameters(QString host, QString port, QString user, QString pass, QString schema, QString createXML, QString outputDir, bool protectSensitive, QString tempDir, bool incLookups, bool incmsels, QString firstSheetName, QString encryption_key, QString resolve_type, int num_workers)
 {
     this->host = host;
     this->port = port;
@@ -48,6 +48,22 @@ void mainClass::setParameters(QString host, QString port, QString user, QString
     this->firstSheetName = firstSheetName;    
     this->encryption_key = encryption_key;
     this->resolve_type = resolve_type.toInt();
+    this->num_workers = num_workers;
+
+    this->db = QSqlDatabase::addDatabase("QMYSQL","repository");
+    db.setHostName(host);
+    db.setPort(port.toInt());
+    db.setDatabaseName(schema);
+    db.setUserName(user);
+    db.setPassword(pass);
+    if (!db.open())
+    {
+        log("Error while conneting to MySQL");
+        exit(1);
+    }
+    QSqlQuery query(db);
+    query.exec("SET SQL_MODE = ''");
+    query.exec("SET NAMES utf8mb4");
 }
 
 QString mainClass::getSheetDescription(QString name)
@@ -186,6 +202,50 @@ void mainClass::loadTable(QDomNode table)
 
 }
 
+TdtaColumn mainClass::getColumn(TfieldDef field, QString suffix, bool text, bool labels)
+{
+    TdtaColumn column;
+    column.name = field.name + suffix;
+    column.label = field.desc;
+    column.type = field.type;
+    column.text = text;
+    if (labels && field.isLookUp)
+    {
+        column.lookupTable = field.lookupRelTable;
+        if (!valueLabels.contains(field.lookupRelTable))
+            loadValueLabels(field.lookupRelTable, field.lookupRelField);
+    }
+    return column;
+}
+
+//Reads the codes and descriptions of a lookup table. Stata only labels integer values so
+//lookups with other codes keep an empty map and export only the codes
+void mainClass::loadValueLabels(QString table, QString codeField)
+{
+    QMap<int, QString> labels;
+    QString descField = codeField;
+    descField = descField.replace("_cod","_des");
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (query.exec("SELECT " + codeField + "," + descField + " FROM " + table))
+    {
+        while (query.next())
+        {
+            bool isInt;
+            int code = query.value(0).toString().toInt(&isInt);
+            if (!isInt)
+            {
+                labels.clear();
+                break;
+            }
+            labels.insert(code, query.value(1).toString());
+        }
+    }
+    else
+        log("Cannot read the lookup table " + table + ": " + query.lastError().databaseText());
+    valueLabels.insert(table, labels);
+}
+
 int mainClass::generateXLSX()
 {
 
@@ -273,26 +333,22 @@ int mainClass::generateXLSX()
             }
         }
 
-        QDir currDir(tempDir);        
-        QStringList arguments;
-        QProcess *mySQLDumpProcess = new QProcess();        
+        QDir currDir(tempDir);
+        QDir finalDir(outputDirectory);
         QTime procTime;
         procTime.start();
         QString sql;
         QStringList fields;
-        QString uri = user + ":" + pass + "@" + host + "/" + schema;
-        QStringList sheets;
-        QStringList csvs;
+        QList<TdtaColumn> columns;
 
         QVector <TlinkedTable> linked_tables;
         QVector <TmultiSelectTable> multiSelectTables;
 
         for (int pos = 0; pos <= tables.count()-1; pos++)
-        {                                                
-            qDebug() << "Creating temp table " + tables[pos].name;
+        {
             linked_tables.clear();
-            sheets.append(getSheetDescription(tables[pos].desc));
             fields.clear();
+            columns.clear();
             for (int fld = 0; fld < tables[pos].fields.count(); fld++)
             {
                 if (this->protectSensitive)
@@ -304,7 +360,10 @@ int mainClass::generateXLSX()
                             if (tables[pos].fields[fld].isKey == false)
                             {
                                 if (tables[pos].fields[fld].isLookUp == false)
+                                {
                                     fields.append(tables[pos].name + "." + tables[pos].fields[fld].name);
+                                    columns.append(getColumn(tables[pos].fields[fld], "", false, false));
+                                }
                                 else
                                 {
                                     if (this->resolve_type != 1)
@@ -319,9 +378,14 @@ int mainClass::generateXLSX()
                                     {
                                         fields.append(tables[pos].name + "." + tables[pos].fields[fld].name);
                                         fields.append("'' as '" + tables[pos].fields[fld].name + "-desc'");
+                                        columns.append(getColumn(tables[pos].fields[fld], "", false, true));
+                                        columns.append(getColumn(tables[pos].fields[fld], "-desc", true, false));
                                     }
                                     else
+                                    {
                                         fields.append(tables[pos].name + "." + tables[pos].fields[fld].name);
+                                        columns.append(getColumn(tables[pos].fields[fld], "", this->resolve_type == 2, this->resolve_type == 1));
+                                    }
                                 }
                             }
                             else
@@ -330,14 +394,19 @@ int mainClass::generateXLSX()
                                 {
 
                                     fields.append(tables[pos].name + "." + tables[pos].fields[fld].name);
+                                    columns.append(getColumn(tables[pos].fields[fld], "", false, false));
                                 }
                                 else
+                                {
                                     fields.append("HEX(AES_ENCRYPT(" + tables[pos].name + "." + tables[pos].fields[fld].name + ",UNHEX('" + this->encryption_key + "'))) as " + tables[pos].fields[fld].name);
+                                    columns.append(getColumn(tables[pos].fields[fld], "", true, false));
+                                }
                             }
                         }
                         else
-                        {                            
+                        {
                             fields.append(tables[pos].fields[fld].name);
+                            columns.append(getColumn(tables[pos].fields[fld], "", true, false));
                             TmultiSelectTable a_multiSelectTable;
                             a_multiSelectTable.field = tables[pos].fields[fld].name;
                             a_multiSelectTable.multiSelectTable = tables[pos].fields[fld].multiSelectTable;
@@ -347,13 +416,19 @@ int mainClass::generateXLSX()
                             a_multiSelectTable.multiSelectKeys.append(tables[pos].fields[fld].multiSelectKeys);
                             multiSelectTables.append(a_multiSelectTable);
                             if (this->resolve_type == 3)
+                            {
                                 fields.append("'' as '" + tables[pos].fields[fld].name + "-desc'");
+                                columns.append(getColumn(tables[pos].fields[fld], "-desc", true, false));
+                            }
                         }
                     }
                     else
                     {
                         if (tables[pos].fields[fld].protection != "exclude")
+                        {
                             fields.append("HEX(AES_ENCRYPT(" + tables[pos].name + "." + tables[pos].fields[fld].name + ",UNHEX('" + this->encryption_key + "'))) as " + tables[pos].fields[fld].name);
+                            columns.append(getColumn(tables[pos].fields[fld], "", true, false));
+                        }
                     }
                 }
                 else
@@ -361,7 +436,10 @@ int mainClass::generateXLSX()
                     if (tables[pos].fields[fld].isMultiSelect == false)
                     {
                         if (tables[pos].fields[fld].isLookUp == false)
+                        {
                             fields.append(tables[pos].name + "." + tables[pos].fields[fld].name);
+                            columns.append(getColumn(tables[pos].fields[fld], "", false, false));
+                        }
                         else
                         {
                             if (this->resolve_type != 1)
@@ -376,14 +454,20 @@ int mainClass::generateXLSX()
                             {
                                 fields.append(tables[pos].name + "." + tables[pos].fields[fld].name);
                                 fields.append("'' as '" + tables[pos].fields[fld].name + "-desc'");
+                                columns.append(getColumn(tables[pos].fields[fld], "", false, true));
+                                columns.append(getColumn(tables[pos].fields[fld], "-desc", true, false));
                             }
                             else
+                            {
                                 fields.append(tables[pos].name + "." + tables[pos].fields[fld].name);
+                                columns.append(getColumn(tables[pos].fields[fld], "", this->resolve_type == 2, this->resolve_type == 1));
+                            }
                         }
                     }
                     else
-                    {                       
+                    {
                         fields.append(tables[pos].fields[fld].name);
+                        columns.append(getColumn(tables[pos].fields[fld], "", true, false));
                         TmultiSelectTable a_multiSelectTable;
                         a_multiSelectTable.field = tables[pos].fields[fld].name;
                         a_multiSelectTable.multiSelectTable = tables[pos].fields[fld].multiSelectTable;
@@ -393,55 +477,28 @@ int mainClass::generateXLSX()
                         a_multiSelectTable.multiSelectKeys.append(tables[pos].fields[fld].multiSelectKeys);
                         multiSelectTables.append(a_multiSelectTable);
                         if (this->resolve_type == 3)
+                        {
                             fields.append("'' as '" + tables[pos].fields[fld].name + "-desc'");
+                            columns.append(getColumn(tables[pos].fields[fld], "-desc", true, false));
+                        }
                     }
                 }
             }
-            QString temp_table;
-            sql = "SET SQL_MODE = '';\nSTART TRANSACTION;\n";
 
+            TtaskItem a_task;
+            a_task.table = tables[pos].name;
+            a_task.label = getSheetDescription(tables[pos].desc);
             QUuid recordUUID=QUuid::createUuid();
-            temp_table = "TMP_" + recordUUID.toString().replace("{","").replace("}","").replace("-","_");
-            sql = sql + "CREATE TABLE " + temp_table + " ENGINE=MyISAM DEFAULT CHARACTER SET utf8mb4 DEFAULT COLLATE utf8mb4_unicode_ci AS SELECT " + fields.join(",") + " FROM " + tables[pos].name + ";\nCOMMIT;\n";
-
-            arguments.clear();
-            arguments.append("--host=" + this->host);
-            arguments.append("--port=" + this->port);
-            arguments.append("--password=" + this->pass);
-            arguments.append("--user=" + this->user);
-            arguments.append("--database=" + this->schema);
-
-            QFile tempfile(currDir.absolutePath() + currDir.separator() + tables[pos].name + ".sql");
-            if (!tempfile.open(QIODevice::WriteOnly | QIODevice::Text))
-            {
-                delete mySQLDumpProcess;
-                return 1;
-            }
-            QTextStream temout(&tempfile);
-            temout << sql;
-            tempfile.close();
-
-            mySQLDumpProcess->setStandardInputFile(currDir.absolutePath() + currDir.separator() + tables[pos].name + ".sql");
-            mySQLDumpProcess->setStandardOutputFile(QProcess::nullDevice());
-            mySQLDumpProcess->start("mysql", arguments);
-            mySQLDumpProcess->waitForFinished(-1);
-            if (mySQLDumpProcess->exitCode() > 0)
-            {
-                QString serror = mySQLDumpProcess->readAllStandardError();
-                log(serror);
-                delete mySQLDumpProcess;
-                return 1;
-            }
-            arguments.clear();
-
-            QStringList sqls;
-            qDebug() << "Performing Alters on temp table";
-            sqls.append("START TRANSACTION;\n");
+            QString temp_table = "TMP_" + recordUUID.toString().replace("{","").replace("}","").replace("-","_");
+            a_task.temp_table = temp_table;
+            a_task.sqls.append("CREATE TABLE " + temp_table + " ENGINE=MyISAM DEFAULT CHARACTER SET utf8mb4 DEFAULT COLLATE utf8mb4_unicode_ci AS SELECT " + fields.join(",") + " FROM " + tables[pos].name);
+            //The rows are numbered so the worker reads them in pages
+            a_task.sqls.append("ALTER TABLE " + temp_table + " ADD COLUMN `odktools_row` INT UNSIGNED PRIMARY KEY AUTO_INCREMENT");
 
             for (int fld = 0; fld < tables[pos].fields.count(); fld++)
             {
                 if (tables[pos].fields[fld].isKey)
-                    sqls.append("ALTER TABLE " + temp_table + " MODIFY COLUMN " + tables[pos].fields[fld].name + " VARCHAR(255) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci;\n");
+                    a_task.sqls.append("ALTER TABLE " + temp_table + " MODIFY COLUMN " + tables[pos].fields[fld].name + " VARCHAR(255) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci");
             }
 
             if (multiSelectTables.count() > 0)
@@ -453,8 +510,8 @@ int mainClass::generateXLSX()
                     if (this->resolve_type == 3)
                         modifies.append("MODIFY COLUMN `" + multiSelectTables[i_table].field + "-desc` TEXT");
                 }
-                sql = "ALTER TABLE " + temp_table + " " + modifies.join(",") + ";\n";
-                sqls.append(sql);
+                sql = "ALTER TABLE " + temp_table + " " + modifies.join(",");
+                a_task.sqls.append(sql);
             }
 
             if (linked_tables.count() > 0)
@@ -470,8 +527,8 @@ int mainClass::generateXLSX()
                     sql = sql + " TEXT";
                     modifies.append(sql);
                 }
-                sql = "ALTER TABLE " + temp_table + " " + modifies.join(",") + ";\n";
-                sqls.append(sql);
+                sql = "ALTER TABLE " + temp_table + " " + modifies.join(",");
+                a_task.sqls.append(sql);
 
 
                 for (int i_table=0; i_table < linked_tables.count(); i_table++)
@@ -482,8 +539,8 @@ int mainClass::generateXLSX()
                         sql = sql + temp_table + "." + linked_tables[i_table].field + " = T" + QString::number(i_table) + "." + relfield.replace("_cod","_des");
                     else
                         sql = sql + temp_table + ".`" + linked_tables[i_table].field + "-desc` = T" + QString::number(i_table) + "." + relfield.replace("_cod","_des");
-                    sql = sql + " WHERE " + temp_table + "." + linked_tables[i_table].field + " = T" + QString::number(i_table) + "." + linked_tables[i_table].related_field + ";\n";
-                    sqls.append(sql);
+                    sql = sql + " WHERE " + temp_table + "." + linked_tables[i_table].field + " = T" + QString::number(i_table) + "." + linked_tables[i_table].related_field;
+                    a_task.sqls.append(sql);
                 }
             }
             if (multiSelectTables.count() > 0)
@@ -501,8 +558,8 @@ int mainClass::generateXLSX()
                             groups.append("TB." + multiSelectTables[i_table].multiSelectKeys[a_key]);
                         }
                         sql = sql + " WHERE " + wheres.join(" AND ");
-                        sql = sql + " GROUP BY " + groups.join(",") + ");\n";
-                        sqls.append(sql);
+                        sql = sql + " GROUP BY " + groups.join(",") + ")";
+                        a_task.sqls.append(sql);
                     }
                     if (this->resolve_type == 2)
                     {
@@ -518,8 +575,8 @@ int mainClass::generateXLSX()
                             groups.append("TB." + multiSelectTables[i_table].multiSelectKeys[a_key]);
                         }
                         sql = sql + " AND " + wheres.join(" AND ");
-                        sql = sql + " GROUP BY " + groups.join(",") + ");\n";
-                        sqls.append(sql);
+                        sql = sql + " GROUP BY " + groups.join(",") + ")";
+                        a_task.sqls.append(sql);
                     }
                     if (this->resolve_type == 3)
                     {
@@ -535,214 +592,72 @@ int mainClass::generateXLSX()
                             groups.append("TB." + multiSelectTables[i_table].multiSelectKeys[a_key]);
                         }
                         sql = sql + " AND " + wheres.join(" AND ");
-                        sql = sql + " GROUP BY " + groups.join(",") + ");\n";
-                        sqls.append(sql);
+                        sql = sql + " GROUP BY " + groups.join(",") + ")";
+                        a_task.sqls.append(sql);
                     }
                 }
             }
-//            for (int p=0; p < sqls.count(); p++)
-//                qDebug() << sqls[p];
-            sqls.append("COMMIT;\n");
-            if (sqls.count() > 0)
-            {
-                QFile modfile(currDir.absolutePath() + currDir.separator() + tables[pos].name + ".sql");
-                if (!modfile.open(QIODevice::WriteOnly | QIODevice::Text))
-                {
-                    delete mySQLDumpProcess;
-                    return 1;
-                }
-                QTextStream modOut(&modfile);
-                for (int isql=0; isql < sqls.count(); isql++)
-                    modOut << sqls[isql];
-                modfile.close();
-
-                arguments.clear();
-                arguments.append("--host=" + this->host);
-                arguments.append("--port=" + this->port);
-                arguments.append("--password=" + this->pass);
-                arguments.append("--user=" + this->user);
-                arguments.append("--database=" + this->schema);
-
-                mySQLDumpProcess->setStandardInputFile(currDir.absolutePath() + currDir.separator() + tables[pos].name + ".sql");
-                mySQLDumpProcess->setStandardOutputFile(QProcess::nullDevice());
-                mySQLDumpProcess->start("mysql", arguments);
-                mySQLDumpProcess->waitForFinished(-1);
-                if (mySQLDumpProcess->exitCode() > 0)
-                {
-                    QString serror = mySQLDumpProcess->readAllStandardError();
-                    log(serror);
-                    delete mySQLDumpProcess;
-                    return 1;
-                }
-            }
-
-            // Export the structure of the temporary table JSON format
-            arguments.clear();
-            arguments << "--sql";
-            arguments << "--result-format=json/array";
-            arguments << "--uri=" + uri;
-            arguments << "--execute=desc " + temp_table;
-            mySQLDumpProcess->setStandardInputFile(QProcess::nullDevice());
-            mySQLDumpProcess->setStandardOutputFile(currDir.absolutePath() + currDir.separator() + tables[pos].name + ".json");
-
-            mySQLDumpProcess->start("mysqlsh", arguments);
-            mySQLDumpProcess->waitForFinished(-1);
-            if ((mySQLDumpProcess->exitCode() > 0) || (mySQLDumpProcess->error() == QProcess::FailedToStart))
-            {
-                if (mySQLDumpProcess->error() == QProcess::FailedToStart)
-                {
-                    log("Error: Command mysqlsh not found");
-                }
-                else
-                {
-                    log("Running mysqlsh returned error");
-                    QString serror = mySQLDumpProcess->readAllStandardError();
-                    log(serror);
-                    log("Running paremeters:" + arguments.join(" "));
-                }
-                delete mySQLDumpProcess;
-                return 1;
-            }
-
-            QFile loadFile(currDir.absolutePath() + currDir.separator() + tables[pos].name + ".json");
-
-            if (!loadFile.open(QIODevice::ReadOnly)) {
-                log("Couldn't open json structure file.");
-                delete mySQLDumpProcess;
-                return 1;
-            }
-            QByteArray jsonData = loadFile.readAll();
-            QJsonDocument loadDoc(QJsonDocument::fromJson(jsonData));
-            QJsonArray fields = loadDoc.array();
-            QStringList fields_to_select;
-            for (auto a_field : fields)
-            {
-                QJsonObject element = a_field.toObject();
-                fields_to_select << "ifnull(`" + element["Field"].toString() + "`,'') as `" + element["Field"].toString() + "`";
-            }
 
+            a_task.columns = columns;
+            a_task.dta_file = finalDir.absolutePath() + currDir.separator() + tables[pos].name + ".dta";
+            a_task.strl_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + ".strl";
+            task_list.append(a_task);
 
             linked_tables.clear();
             multiSelectTables.clear();
-            qDebug() << "Parsing table " + tables[pos].name + " to TAB format";
-            sql = "SELECT " + fields_to_select.join(",") + " FROM " + temp_table + ";";
-
-            arguments.clear();
-            arguments << "--sql";
-            arguments << "--result-format=tabbed";
-            arguments << "--uri=" + uri;
-            QFile sqlfile(currDir.absolutePath() + currDir.separator() + tables[pos].name + ".sql");
-            if (!sqlfile.open(QIODevice::WriteOnly | QIODevice::Text))
-            {
-                delete mySQLDumpProcess;
-                return 1;
-            }
-            QTextStream out(&sqlfile);
-            out << sql;
-            sqlfile.close();
-            mySQLDumpProcess->setStandardInputFile(currDir.absolutePath() + currDir.separator() + tables[pos].name + ".sql");
-            mySQLDumpProcess->setStandardOutputFile(currDir.absolutePath() + currDir.separator() + tables[pos].name + ".raw");
-            mySQLDumpProcess->start("mysqlsh", arguments);
-            mySQLDumpProcess->waitForFinished(-1);
-            if ((mySQLDumpProcess->exitCode() > 0) || (mySQLDumpProcess->error() == QProcess::FailedToStart))
-            {
-                if (mySQLDumpProcess->error() == QProcess::FailedToStart)
-                {
-                    log("Error: Command mysqlsh not found");
-                }
-                else
-                {
-                    log("Running mysqlsh returned error");
-                    QString serror = mySQLDumpProcess->readAllStandardError();
-                    log(serror);
-                    log("Running paremeters:" + arguments.join(" "));
-                }
-                delete mySQLDumpProcess;
-                return 1;
-            }
-
-
-            QString do_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + ".do";
-
-            QFile dofile(do_file);
-            if (!dofile.open(QIODevice::WriteOnly | QIODevice::Text))
-            {
-                log("Cannot open DCF file for writing");
-                delete mySQLDumpProcess;
-                return 1;
-            }
-            QTextStream do_out(&dofile);
-            do_out << "/* This script will generate a STATA " + tables[pos].name + ".dta file from a " + tables[pos].name + ".raw tab delimited file*/\n";
-            do_out << "/* You only need to run this once.*/\n";
-            do_out << "/* Change c:\\my_working_dir to the directory holding this file.*/\n";
-            do_out << "cd \"c:\\my_working_dir\"\n";
-            do_out << "import delimited \"" + tables[pos].name + ".raw\", delimiter(tab) varnames(1) encoding(UTF-8) stringcols(_all)\n";
-
-
-
-            for (auto a_field : fields)
-            {
-                QString line_data;
-                QJsonObject element = a_field.toObject();
-                if (element["Type"].toString() == "double")
-                    line_data = "destring " + element["Field"].toString() + ", replace float force\n";
-                if (element["Type"].toString().indexOf("decimal") >= 0)
-                    line_data = "destring " + element["Field"].toString() + ", replace float force\n";
-                if (element["Type"].toString().indexOf("int") >= 0)
-                    line_data =  "destring " + element["Field"].toString() + ", replace force\n";
-                if (element["Type"].toString().indexOf("varchar") >= 0)
-                {
-                    QRegExp exp("\\(([^()]*)\\)");
-                    exp.indexIn(element["Type"].toString());
-                    QString zize = exp.cap(1);
-                    line_data =  "recast str"+ zize + " " + element["Field"].toString() + ", force\n";
-                }
-                if (line_data != "")
-                    do_out << line_data;
-
-            }
-            do_out << "save " + tables[pos].name + "\n";
-            do_out << "clear";
-            dofile.close();
-            loadFile.close();
-
-            arguments.clear();
-            arguments.append("--host=" + this->host);
-            arguments.append("--port=" + this->port);
-            arguments.append("--password=" + this->pass);
-            arguments.append("--user=" + this->user);
-            arguments.append("--database=" + this->schema);
-            arguments.append("--execute=DROP TABLE " + temp_table );
-
-            mySQLDumpProcess->setStandardInputFile(QProcess::nullDevice());
-            mySQLDumpProcess->setStandardOutputFile(QProcess::nullDevice());
-            mySQLDumpProcess->start("mysql", arguments);
-            mySQLDumpProcess->waitForFinished(-1);
-            if (mySQLDumpProcess->exitCode() > 0)
-            {
-                QString serror = mySQLDumpProcess->readAllStandardError();
-                log(serror);
-                delete mySQLDumpProcess;
-                return 1;
-            }
-
-            QString tab_file = currDir.absolutePath() + currDir.separator() + tables[pos].name + ".raw";
-
-            csvs.append(tab_file);
-            csvs.append(do_file);
         }
 
-
-        for (int pos = 0; pos < csvs.count(); pos++)
+        //The largest tables go first so the wall time is bound by the largest table and not by the one
+        //that happens to be the last in the list
+        QHash<QString, qint64> table_rows;
+        QSqlQuery query(db);
+        query.prepare("SELECT TABLE_NAME,TABLE_ROWS FROM information_schema.TABLES WHERE TABLE_SCHEMA = ?");
+        query.addBindValue(schema);
+        if (query.exec())
         {
-            QString newpath;
-            newpath = csvs[pos];
-            newpath.replace(currDir.absolutePath() + currDir.separator(), outputDirectory + currDir.separator());
-            if (QFile::copy(csvs[pos], newpath))
-                QFile::remove(csvs[pos]);
+            while (query.next())
+                table_rows.insert(query.value(0).toString(), query.value(1).toLongLong());
         }
-
-        delete mySQLDumpProcess;
+        std::stable_sort(task_list.begin(), task_list.end(), [&table_rows](const TtaskItem &a, const TtaskItem &b) {
+            return table_rows.value(a.table) > table_rows.value(b.table);
+        });
+
+        int workers = num_workers;
+        if (workers > task_list.count())
+            workers = task_list.count();
+        if (workers < 1)
+            workers = 1;
+
+        ListMutex *mutex = new ListMutex(this);
+        mutex->set_total(task_list.count());
+        QList< tableWorker*> worker_list;
+        for (int w=1; w <= workers; w++)
+        {
+            tableWorker *a_worker = new tableWorker(this);
+            a_worker->setName("Worker" + QString::number(w));
+            a_worker->setParameters(host, port, user, pass, schema);
+            a_worker->setValueLabels(&valueLabels);
+            a_worker->setTasks(task_list);
+            a_worker->setMutex(mutex);
+            worker_list.append(a_worker);
+        }
+        for (int w=0; w < worker_list.count(); w++)
+        {
+            worker_list[w]->start();
+        }
+        for (int w=0; w < worker_list.count(); w++)
+        {
+            worker_list[w]->wait();
+        }
+        for (int w=0; w < worker_list.count(); w++)
+        {
+            if (worker_list[w]->status != 0)
+                returnCode = 1;
+            delete worker_list[w];
+        }
+        delete mutex;
+        if (returnCode != 0)
+            return returnCode;
 
         int Hours;
         int Minutes;
@@ -3,6 +3,9 @@
 
 #include <QObject>
 #include <QDomNode>
+#include <QSqlDatabase>
+#include <QHash>
+#include <QMap>
 
 struct fieldDef
 {
@@ -56,12 +59,36 @@ struct multiSelectTable
 };
 typedef multiSelectTable TmultiSelectTable;
 
+//A column of the temporary table exported to the .dta file
+struct dtaColumn
+{
+    QString name;
+    QString label;
+    QString type; //Type in the create XML
+    bool text = false; //The column holds descriptions or protected values
+    QString lookupTable; //Lookup table used for the value labels. Empty if none
+};
+typedef dtaColumn TdtaColumn;
+
+//A table to export
+struct taskItem
+{
+    QString table;
+    QString label;
+    QString temp_table;
+    QStringList sqls; //Creates and fills the temporary table
+    QList<TdtaColumn> columns;
+    QString dta_file;
+    QString strl_file;
+};
+typedef taskItem TtaskItem;
+
 class mainClass : public QObject
 {
     Q_OBJECT
 public:
     explicit mainClass(QObject *parent = nullptr);
-    void setParameters(QString host, QString port, QString user, QString pass, QString schema, QString createXML, QString outputDir, bool protectSensitive, QString tempDir, bool incLookups, bool incmsels, QString firstSheetName, QString encryption_key, QString resolve_type);
+    void setParameters(QString host, QString port, QString user, QString pass, QString schema, QString createXML, QString outputDir, bool protectSensitive, QString tempDir, bool incLookups, bool incmsels, QString firstSheetName, QString encryption_key, QString resolve_type, int num_workers);
     int returnCode;
 signals:
     void finished();
@@ -73,6 +100,11 @@ private:
     QString getSheetDescription(QString name);
     void loadTable(QDomNode node);
     void getMultiSelectInfo(QDomNode table, QString table_name, QString &multiSelect_field, QStringList &keys, QString &rel_table, QString &rel_field);
+    TdtaColumn getColumn(TfieldDef field, QString suffix, bool text, bool labels);
+    void loadValueLabels(QString table, QString codeField);
+    QSqlDatabase db;
+    QHash<QString, QMap<int, QString> > valueLabels; //Labels of each lookup table. Empty if the codes are not integers
+    QList<TtaskItem> task_list;
     QString host;
     QString port;
     QString user;
@@ -83,6 +115,7 @@ private:
     QString createXML;
     QString encryption_key;
     int resolve_type = 1;
+    int num_workers = 1;
     bool protectSensitive;
     QList<TtableDef> tables;
     QList<TtableDef> mainTables;
@@ -0,0 +1,246 @@
+#include "tableworker.h"
+#include <QFile>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSqlRecord>
+#include "dtawriter.h"
+
+//Rows read from MySQL in each query. QMYSQL stores the whole result of a query in memory
+#define ROWS_PER_PAGE 10000
+
+tableWorker::tableWorker(QObject *parent)
+    : QThread{parent}
+{
+
+}
+
+void tableWorker::setParameters(QString host, QString port, QString user, QString pass, QString schema)
+{
+    this->host = host;
+    this->port = port;
+    this->user = user;
+    this->pass = pass;
+    this->schema = schema;
+}
+
+void tableWorker::setName(QString name)
+{
+    this->name = name;
+}
+
+void tableWorker::setTasks(QList< TtaskItem> task_list)
+{
+    this->task_list = task_list;
+}
+
+void tableWorker::setMutex(ListMutex *mutex)
+{
+    this->mutex = mutex;
+}
+
+//The value labels are loaded by mainClass before the workers start and are only read here
+void tableWorker::setValueLabels(const QHash<QString, QMap<int, QString> > *valueLabels)
+{
+    this->valueLabels = valueLabels;
+}
+
+void tableWorker::log(QString message)
+{
+    QString temp;
+    temp = message + "\n";
+    printf("%s", temp.toUtf8().data());
+}
+
+//A connection can only be used by the thread that created it
+int tableWorker::openConnection(QSqlDatabase &db, QString connection_name)
+{
+    db = QSqlDatabase::addDatabase("QMYSQL",connection_name);
+    db.setHostName(host);
+    db.setPort(port.toInt());
+    db.setDatabaseName(schema);
+    db.setUserName(user);
+    db.setPassword(pass);
+    if (!db.open())
+    {
+        log(name + " - Error while conneting to MySQL: " + db.lastError().databaseText());
+        return 1;
+    }
+    QSqlQuery qry(db);
+    qry.exec("SET SQL_MODE = ''");
+    qry.exec("SET NAMES utf8mb4");
+    return 0;
+}
+
+void tableWorker::run()
+{
+    QSqlDatabase db;
+    this->status = 0;
+    if (openConnection(db, name) != 0)
+    {
+        this->status = 1;
+        mutex->abort();
+    }
+
+    int index = -1;
+    if (this->status == 0)
+        index = mutex->get_index();
+    while (index >= 0)
+    {
+        log(name + " - Exporting " + task_list[index].table);
+        if (exportTable(db, task_list[index]) != 0)
+        {
+            this->status = 1;
+            mutex->abort();
+            break;
+        }
+        index = mutex->get_index();
+    }
+
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(name);
+}
+
+//Creates the temporary table, finds the storage type of each column and writes the rows to the .dta file.
+//The rows of the temporary table are numbered and read in pages of ROWS_PER_PAGE, so the memory does not
+//depend on the size of the table
+int tableWorker::exportTable(QSqlDatabase &db, TtaskItem task)
+{
+    QSqlQuery query(db);
+    int res = 0;
+    for (int pos = 0; pos < task.sqls.count(); pos++)
+    {
+        if (!query.exec(task.sqls[pos]))
+        {
+            log(name + " - Error while creating the temporary table of " + task.table + ": " + query.lastError().databaseText());
+            log(task.sqls[pos]);
+            res = 1;
+            break;
+        }
+    }
+
+    //Range of the integer columns and maximum length of the strings
+    QStringList stats;
+    if (res == 0)
+    {
+        for (int pos = 0; pos < task.columns.count(); pos++)
+        {
+            QString name = "`" + task.columns[pos].name + "`";
+            if ((!task.columns[pos].text) && (task.columns[pos].type == "int"))
+            {
+                stats.append("MIN(" + name + "+0)");
+                stats.append("MAX(" + name + "+0)");
+            }
+            else
+            {
+                if ((task.columns[pos].text) || ((task.columns[pos].type != "decimal") && (task.columns[pos].type != "date") && (task.columns[pos].type != "datetime")))
+                    stats.append("MAX(LENGTH(" + name + "))");
+            }
+        }
+        if (stats.count() > 0)
+        {
+            query.setForwardOnly(true);
+            if (!query.exec("SELECT " + stats.join(",") + " FROM " + task.temp_table))
+            {
+                log(name + " - Error while reading the ranges of " + task.table + ": " + query.lastError().databaseText());
+                res = 1;
+            }
+            else
+                query.next();
+        }
+    }
+
+    if (res == 0)
+    {
+        dtaWriter writer;
+        QHash<QString, QString> labelNames;
+        QStringList selects;
+        int stat = 0;
+        writer.setLabel(task.label);
+        for (int pos = 0; pos < task.columns.count(); pos++)
+        {
+            TdtaColumn column = task.columns[pos];
+            selects.append("`" + column.name + "`");
+            if ((!column.text) && (column.type == "int"))
+            {
+                qint64 min = query.value(stat).toLongLong();
+                qint64 max = query.value(stat + 1).toLongLong();
+                stat = stat + 2;
+                int type = dtaWriter::dtaDouble;
+                if ((min >= -127) && (max <= 100))
+                    type = dtaWriter::dtaByte;
+                else if ((min >= -32767) && (max <= 32740))
+                    type = dtaWriter::dtaInt;
+                else if ((min >= -2147483647) && (max <= 2147483620))
+                    type = dtaWriter::dtaLong;
+                QString valueLabel;
+                if ((column.lookupTable != "") && (type != dtaWriter::dtaDouble) && (!valueLabels->value(column.lookupTable).isEmpty()))
+                {
+                    if (!labelNames.contains(column.lookupTable))
+                        labelNames.insert(column.lookupTable, writer.addValueLabel(column.lookupTable, valueLabels->value(column.lookupTable)));
+                    valueLabel = labelNames.value(column.lookupTable);
+                }
+                writer.addNumber(column.name, column.label, type, valueLabel);
+                continue;
+            }
+            if ((!column.text) && (column.type == "decimal"))
+            {
+                writer.addNumber(column.name, column.label, dtaWriter::dtaDouble);
+                continue;
+            }
+            if ((!column.text) && ((column.type == "date") || (column.type == "datetime")))
+            {
+                writer.addDate(column.name, column.label, column.type == "datetime");
+                continue;
+            }
+            writer.addString(column.name, column.label, query.value(stat).toInt());
+            stat++;
+        }
+
+        if (writer.open(task.dta_file, task.strl_file) != 0)
+        {
+            log(name + " - Cannot create " + task.dta_file);
+            res = 1;
+        }
+        else
+        {
+            query.setForwardOnly(true);
+            int first = 1;
+            int rows = ROWS_PER_PAGE;
+            while ((res == 0) && (rows == ROWS_PER_PAGE))
+            {
+                rows = 0;
+                if (!query.exec("SELECT " + selects.join(",") + " FROM " + task.temp_table + " WHERE `odktools_row` BETWEEN " + QString::number(first) + " AND " + QString::number(first + ROWS_PER_PAGE - 1) + " ORDER BY `odktools_row`"))
+                {
+                    log(name + " - Error while reading " + task.table + ": " + query.lastError().databaseText());
+                    res = 1;
+                    break;
+                }
+                while (query.next())
+                {
+                    writer.writeRow(query.record());
+                    rows++;
+                }
+                first = first + ROWS_PER_PAGE;
+            }
+            if (res == 0)
+            {
+                if (writer.close() != 0)
+                {
+                    log(name + " - Error while writing " + task.dta_file);
+                    res = 1;
+                }
+                else
+                    log(task.table + ": " + QString::number(writer.rows()) + " rows");
+            }
+            else
+                writer.close();
+        }
+        if (res != 0)
+            QFile::remove(task.dta_file);
+    }
+
+    QSqlQuery drop(db);
+    drop.exec("DROP TABLE IF EXISTS " + task.temp_table);
+    return res;
+}
@@ -0,0 +1,38 @@
+#ifndef TABLEWORKER_H
+#define TABLEWORKER_H
+
+#include <QThread>
+#include <QSqlDatabase>
+#include "listmutex.h"
+#include "mainclass.h"
+
+//Exports whole tables to .dta files. Each worker has its own connection and takes the next table
+//from the list until all are done
+class tableWorker : public QThread
+{
+    Q_OBJECT
+public:
+    explicit tableWorker(QObject *parent = nullptr);
+    void run();
+    void setTasks(QList< TtaskItem> task_list);
+    void setMutex(ListMutex *mutex);
+    void setValueLabels(const QHash<QString, QMap<int, QString> > *valueLabels);
+    void setName(QString name);
+    void setParameters(QString host, QString port, QString user, QString pass, QString schema);
+    int status;
+private:
+    void log(QString message);
+    int openConnection(QSqlDatabase &db, QString connection_name);
+    int exportTable(QSqlDatabase &db, TtaskItem task);
+    QList< TtaskItem> task_list;
+    ListMutex *mutex;
+    const QHash<QString, QMap<int, QString> > *valueLabels;
+    QString host;
+    QString port;
+    QString pass;
+    QString user;
+    QString schema;
+    QString name;
+};
+
+#endif // TABLEWORKER_H
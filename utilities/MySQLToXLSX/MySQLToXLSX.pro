@@ -18,12 +18,22 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 unix:INCLUDEPATH += ../../3rdparty
 
+LIBS += -lquazip1-qt5 -lz
+
 SOURCES += main.cpp \
     jsonworker.cpp \
     listmutex.cpp \
-    mainclass.cpp
+    mainclass.cpp \
+    rowresolver.cpp \
+    rowwriter.cpp \
+    sheetwriter.cpp \
+    xlsxwriter.cpp
 
 HEADERS += \
     jsonworker.h \
     listmutex.h \
-    mainclass.h
+    mainclass.h \
+    rowresolver.h \
+    rowwriter.h \
+    sheetwriter.h \
+    xlsxwriter.h
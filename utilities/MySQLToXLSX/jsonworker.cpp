@@ -2,12 +2,12 @@
 #include <QFile>
 #include <QTextStream>
 #include <QFileInfo>
-#include <QProcess>
-#include <QProcessEnvironment>
 #include <QDebug>
-#include <QFileInfo>
-#include <QUuid>
-#include <QUrl>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSqlRecord>
+#include "rowwriter.h"
+#include "xlsxwriter.h"
 
 JSONWorker::JSONWorker(QObject *parent)
     : QThread{parent}
@@ -38,211 +38,235 @@ void JSONWorker::log(QString message)
     printf("%s", temp.toUtf8().data());
 }
 
-void JSONWorker::run()
+//Each worker has its own connection. A connection can only be used by the thread that created it
+int JSONWorker::openConnection(QSqlDatabase &db, QString connection_name)
 {
-    QProcess *mySQLDumpProcess = new QProcess();
-    QStringList arguments;
-    QString fixed_pass(QUrl::toPercentEncoding(pass));
-    QString fixed_user(QUrl::toPercentEncoding(user));
-    QString uri = fixed_user + ":" + fixed_pass + "@" + host + ":" + port +  "/" + schema;
+    db = QSqlDatabase::addDatabase("QMYSQL",connection_name);
+    db.setHostName(host);
+    db.setPort(port.toInt());
+    db.setDatabaseName(schema);
+    db.setUserName(user);
+    db.setPassword(pass);
+    if (!db.open())
+    {
+        log(name + " - Error while conneting to MySQL: " + db.lastError().databaseText());
+        return 1;
+    }
+    QSqlQuery qry(db);
+    qry.exec("SET NAMES utf8mb4");
+    return 0;
+}
 
-    int index = mutex->get_index();
-    //qDebug() << name + " - Processing index: " + QString::number(index);
-    while (index >= 0)
+//Runs the statements of a SQL file one by one. The files are created by mainClass with one statement per line
+int JSONWorker::execSQLFile(QSqlDatabase &db, QString sql_file)
+{
+    QFile file(sql_file);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
     {
-        //qDebug() << name + " - Processing index: " + QString::number(index);
-        // Create the table
-        if (task_list[index].task_type == 1)
-        {
-            //qDebug() << name + " - Processing file: " + task_list[index].sql_file;
-            arguments.clear();
-            arguments.append("--host=" + this->host);
-            arguments.append("--port=" + this->port);
-            arguments.append("--password=" + this->pass);
-            arguments.append("--user=" + this->user);
-            arguments.append("--database=" + this->schema);
+        log("Cannot open SQL file " + sql_file);
+        return 1;
+    }
+    QString sql = QString::fromUtf8(file.readAll());
+    file.close();
 
-            mySQLDumpProcess->setStandardInputFile(task_list[index].sql_file);
-            mySQLDumpProcess->setStandardOutputFile(QProcess::nullDevice());
-            mySQLDumpProcess->start("mysql", arguments);
-            mySQLDumpProcess->waitForFinished(-1);
-            if (mySQLDumpProcess->exitCode() > 0)
-            {
-                QString serror = mySQLDumpProcess->readAllStandardError();
-                log(serror);
-                delete mySQLDumpProcess;
-                this->status = 1;
-                return;
-            }
-        }
-        if (task_list[index].task_type == 2)
+    QStringList statements = sql.split(";\n");
+    QSqlQuery qry(db);
+    for (int pos = 0; pos < statements.count(); pos++)
+    {
+        QString statement = statements[pos].trimmed();
+        if (statement.endsWith(";"))
+            statement.chop(1);
+        if (statement.isEmpty())
+            continue;
+        if (!qry.exec(statement))
         {
-            // Extract the data as json
-            //qDebug() << name + " - Exporting file: " + task_list[index].sql_file;
-
-
-            QUuid home_id=QUuid::createUuid();
-            QString user_home_id=home_id.toString().replace("{","").replace("}","");
-            QFileInfo finfo(task_list[index].sql_file);
-            QString user_home = finfo.canonicalPath() + "/" + user_home_id;
-            QDir().mkdir(user_home);
-
-//            QFile options_file(user_home + "/options.json");
-//            options_file.open(QIODevice::WriteOnly);
-//            options_file.close();
+            log(qry.lastError().databaseText());
+            log("Running statement:" + statement);
+            return 1;
+        }
+    }
+    return 0;
+}
 
-            QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-            env.insert("MYSQLSH_USER_CONFIG_HOME", user_home);
+//Writes the result of the query of a chunk into its sheet. The driver stores the whole result of
+//the query in memory, so the size of the chunks (CHUNK_ROWS) bounds the memory of the worker.
+//A chunk that is not yet the head of the sheet goes to its temporary file and the sheet appends it later
+int JSONWorker::exportQuery(QSqlDatabase &db, TtaskItem task)
+{
+    QFile file(task.sql_file);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        log("Cannot open SQL file " + task.sql_file);
+        task.writer->abort();
+        return 1;
+    }
+    QString sql = QString::fromUtf8(file.readAll()).trimmed();
+    file.close();
+    if (sql.endsWith(";"))
+        sql.chop(1);
 
-            arguments.clear();
-            arguments << "--sql";
-            arguments << "--result-format=json/array";
-            arguments << "--uri=" + uri;
+    int turn = task.writer->beginChunk(task.chunk);
+    if (turn < 0)
+    {
+        log("Another part of sheet " + task.writer->name() + " failed");
+        return 1;
+    }
 
-            mySQLDumpProcess->setProcessEnvironment(env);
-            mySQLDumpProcess->setStandardInputFile(task_list[index].sql_file);
-            mySQLDumpProcess->setStandardOutputFile(task_list[index].json_file);
-            mySQLDumpProcess->start("mysqlsh", arguments);
-            mySQLDumpProcess->waitForFinished(-1);
-            if ((mySQLDumpProcess->exitCode() > 0) || (mySQLDumpProcess->error() == QProcess::FailedToStart))
+    rowWriter writer;
+    if (turn == 0)
+        writer.open(task.writer->device());
+    else
+    {
+        if (writer.open(task.chunk_file) != 0)
+        {
+            log("Cannot create file " + task.chunk_file);
+            task.writer->abort();
+            return 1;
+        }
+    }
+    bool resolve = (task.columns.count() > 0);
+    //The codes of the multi-selects and the rows are read in one snapshot so they see the same rows,
+    //also in read-only mode where the tables can change while they are exported
+    QSqlQuery snapshot(db);
+    bool consistent = (resolve && (task.multiSelect_sql != ""));
+    if (consistent)
+    {
+        if (!snapshot.exec("START TRANSACTION WITH CONSISTENT SNAPSHOT"))
+        {
+            log(snapshot.lastError().databaseText());
+            task.writer->abort();
+            return 1;
+        }
+    }
+    if (resolve)
+    {
+        if (resolver.prepare(db, task) != 0)
+        {
+            log(resolver.lastError());
+            if (consistent)
+                snapshot.exec("ROLLBACK");
+            task.writer->abort();
+            return 1;
+        }
+        //The descriptions repeat a lot so they go to the shared strings
+        QList<bool> shared;
+        for (int col = 0; col < task.columns.count(); col++)
+            shared.append((task.columns[col].action == 1) || (task.columns[col].action == 3));
+        writer.setSharedStrings(task.writer->workbook(), shared, &sharedCache);
+    }
+    QSqlQuery qry(db);
+    qry.setForwardOnly(true);
+    qry.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    bool executed = qry.exec(sql);
+    //Both results are already in the client so the snapshot can end
+    if (consistent)
+        snapshot.exec("COMMIT");
+    if (!executed)
+    {
+        log(qry.lastError().databaseText());
+        log("Running query:" + sql);
+        task.writer->abort();
+        return 1;
+    }
+    if (resolve)
+    {
+        if (task.header)
+            writer.writeHeader(resolver.header());
+        while (qry.next())
+        {
+            if (writer.isFull())
             {
-                if (mySQLDumpProcess->error() == QProcess::FailedToStart)
-                {
-                    log("Error: Command mysqlsh not found");
-                }
-                else
-                {
-                    log("Running mysqlsh returned error");
-                    QString serror = mySQLDumpProcess->readAllStandardError();
-                    log(serror);
-                    log("Running paremeters:" + arguments.join(" "));
-                }
-                delete mySQLDumpProcess;
-                this->status = 1;
-                return;
+                log("The sheet " + task.writer->name() + " has more rows than a sheet of XLSX can hold (" + QString::number(XLSX_MAX_ROWS) + " with the header)");
+                task.writer->abort();
+                return 1;
             }
-            else
+            writer.writeRow(resolver.resolve(qry.record()));
+        }
+    }
+    else
+    {
+        if (task.header)
+            writer.writeHeader(qry.record());
+        while (qry.next())
+        {
+            if (writer.isFull())
             {
-                this->msleep(500);
+                log("The sheet " + task.writer->name() + " has more rows than a sheet of XLSX can hold (" + QString::number(XLSX_MAX_ROWS) + " with the header)");
+                task.writer->abort();
+                return 1;
             }
+            writer.writeRow(qry.record());
         }
-        if (task_list[index].task_type == 3)
+    }
+    if (qry.lastError().isValid())
+    {
+        log(qry.lastError().databaseText());
+        task.writer->abort();
+        return 1;
+    }
+    if (resolve)
+    {
+        if (resolver.finish() != 0)
         {
-            if (task_list[index].json_files.count() > 1)
-            {
-                //qDebug() << name + " - Creating final file: " + task_list[index].final_file;
-                arguments.clear();
-                arguments << "-s";
-                arguments << "reduce .[] as $x ([]; . + $x)";
-                for (int f=0; f < task_list[index].json_files.count(); f++)
-                {
-                    arguments << task_list[index].json_files[f];
-                }
-                mySQLDumpProcess->setStandardInputFile(QProcess::nullDevice());
-                mySQLDumpProcess->setStandardOutputFile(task_list[index].final_file);
+            log(resolver.lastError());
+            task.writer->abort();
+            return 1;
+        }
+    }
+    if (writer.close() != 0)
+    {
+        log("Error writing the rows of " + task.table);
+        task.writer->abort();
+        return 1;
+    }
+    QString target = task.chunk_file;
+    if (turn == 0)
+        target = "";
+    if (task.writer->endChunk(task.chunk, target) != 0)
+    {
+        log("Error writing sheet " + task.writer->name());
+        return 1;
+    }
+    return 0;
+}
 
-                mySQLDumpProcess->start("jq", arguments);
-                mySQLDumpProcess->waitForFinished(-1);
-                if ((mySQLDumpProcess->exitCode() > 0) || (mySQLDumpProcess->error() == QProcess::FailedToStart))
-                {
-                    if (mySQLDumpProcess->error() == QProcess::FailedToStart)
-                    {
-                        log("Error: Command jq not found");
-                    }
-                    else
-                    {
-                        log("Running jq returned error");
-                        QString serror = mySQLDumpProcess->readAllStandardError();
-                        log(serror);
-                        log("Running paremeters:" + arguments.join(" "));
-                    }
-                    delete mySQLDumpProcess;
-                    this->status = 1;
-                    return;
-                }
-            }
-            else
-            {
-                QFile::copy(task_list[index].json_files[0],task_list[index].final_file);
-            }
+void JSONWorker::run()
+{
+    QSqlDatabase db;
+    this->status = 0;
+    if (openConnection(db, name) != 0)
+        this->status = 1;
 
-            QFileInfo info(task_list[index].final_file);
-            if (info.size() > 0)
+    int index = -1;
+    if (this->status == 0)
+        index = mutex->get_index();
+    while (index >= 0)
+    {
+        //qDebug() << name + " - Processing index: " + QString::number(index);
+        // Create the table
+        if (task_list[index].task_type == 1)
+        {
+            if (execSQLFile(db, task_list[index].sql_file) != 0)
             {
-                QString final_csv_file = task_list[index].final_file;
-                final_csv_file = final_csv_file.replace(".json",".csv");
-                arguments.clear();
-                arguments << "-i";
-                arguments << task_list[index].final_file;
-                arguments << "-o";
-                arguments << final_csv_file;
-
-                mySQLDumpProcess->setStandardInputFile(QProcess::nullDevice());
-                mySQLDumpProcess->setStandardOutputFile(QProcess::nullDevice());
-                mySQLDumpProcess->start("json2csv", arguments);
-                mySQLDumpProcess->waitForFinished(-1);
-                if ((mySQLDumpProcess->exitCode() > 0) || (mySQLDumpProcess->error() == QProcess::FailedToStart))
-                {
-                    if (mySQLDumpProcess->error() == QProcess::FailedToStart)
-                    {
-                        log("Error: Command jq not found");
-                    }
-                    else
-                    {
-                        log("Running jq returned error");
-                        QString serror = mySQLDumpProcess->readAllStandardError();
-                        log(serror);
-                        log("Running paremeters:" + arguments.join(" "));
-                    }
-                    delete mySQLDumpProcess;
-                    this->status = 1;
-                    return;
-                }
+                this->status = 1;
+                break;
             }
-            QFile::remove(task_list[index].final_file);            
         }
-        if (task_list[index].task_type == 4)
+        // Extract a chunk
+        if (task_list[index].task_type == 2)
         {
-            QFileInfo info(task_list[index].json_files[0]);
-            if (info.size() > 0)
+            if (exportQuery(db, task_list[index]) != 0)
             {
-                QString final_csv_file = task_list[index].final_file;
-                final_csv_file = final_csv_file.replace(".json",".csv");
-                arguments.clear();
-                arguments << "-i";
-                arguments << task_list[index].json_files[0];
-                arguments << "-o";
-                arguments << final_csv_file;
-
-                mySQLDumpProcess->setStandardInputFile(QProcess::nullDevice());
-                mySQLDumpProcess->setStandardOutputFile(QProcess::nullDevice());
-                mySQLDumpProcess->start("json2csv", arguments);
-                mySQLDumpProcess->waitForFinished(-1);
-                if ((mySQLDumpProcess->exitCode() > 0) || (mySQLDumpProcess->error() == QProcess::FailedToStart))
-                {
-                    if (mySQLDumpProcess->error() == QProcess::FailedToStart)
-                    {
-                        log("Error: Command json2csv not found");
-                    }
-                    else
-                    {
-                        log("Running json2csv returned error");
-                        QString serror = mySQLDumpProcess->readAllStandardError();
-                        log(serror);
-                        log("Running paremeters:" + arguments.join(" "));
-                    }
-                    delete mySQLDumpProcess;
-                    this->status = 1;
-                    return;
-                }
+                this->status = 1;
+                break;
             }
-            QFile::remove(task_list[index].final_file);
         }
         index = mutex->get_index();
     }
 
-    delete mySQLDumpProcess;
-    this->status = 0;
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(name);
 }
 
 void JSONWorker::setTasks(QList< TtaskItem> task_list)
@@ -250,6 +274,11 @@ void JSONWorker::setTasks(QList< TtaskItem> task_list)
     this->task_list = task_list;
 }
 
+void JSONWorker::setLookups(const QHash<QString, QHash<QString, QString> > *lookups)
+{
+    resolver.setLookups(lookups);
+}
+
 void JSONWorker::setMutex(ListMutex *mutex)
 {
     this->mutex = mutex;
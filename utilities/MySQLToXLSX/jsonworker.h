@@ -3,8 +3,10 @@
 
 #include <QThread>
 #include <QDir>
+#include <QSqlDatabase>
 #include "listmutex.h"
 #include "mainclass.h"
+#include "rowresolver.h"
 
 //struct taskItem
 //{
@@ -24,11 +26,15 @@ public:
     void run();
     void setTasks(QList< TtaskItem> task_list);
     void setMutex(ListMutex *mutex);
+    void setLookups(const QHash<QString, QHash<QString, QString> > *lookups);
     void setName(QString name);
     void setParameters(QString host, QString port, QString user, QString pass, QString schema, QDir currDir, QString outputDirectory);
     int status;
 private:
     void log(QString message);
+    int openConnection(QSqlDatabase &db, QString connection_name);
+    int execSQLFile(QSqlDatabase &db, QString sql_file);
+    int exportQuery(QSqlDatabase &db, TtaskItem task);
     QList< TtaskItem> task_list;
     ListMutex *mutex;
     QString host;
@@ -39,6 +45,8 @@ private:
     QDir currDir;
     QString outputDirectory;
     QString name;
+    rowResolver resolver;
+    QHash<QString, int> sharedCache;
 };
 
 #endif // JSONWORKER_H
@@ -0,0 +1,136 @@
+#include "rowresolver.h"
+#include <QSqlError>
+#include <QVariant>
+#include "rowwriter.h"
+
+rowResolver::rowResolver()
+{
+    lookups = nullptr;
+}
+
+void rowResolver::setLookups(const QHash<QString, QHash<QString, QString> > *lookups)
+{
+    this->lookups = lookups;
+}
+
+QString rowResolver::lastError()
+{
+    return error;
+}
+
+QString rowResolver::getKey(const QSqlRecord &record, QList<int> keys)
+{
+    QStringList values;
+    for (int k = 0; k < keys.count(); k++)
+        values.append(record.value(keys[k]).toString());
+    return values.join("\t");
+}
+
+//Reads the codes of the multi-selects of the chunk. The driver stores the whole result anyway, so the codes
+//are kept by the key of their row. A code whose row is not in the chunk, for example because the row was
+//deleted in a live schema, is never asked for and does not move the codes of the rows after it
+int rowResolver::prepare(QSqlDatabase &db, TtaskItem task)
+{
+    columns = task.columns;
+    keys = task.keys;
+    int numKeys = keys.count();
+    chunkCodes.clear();
+    codes.clear();
+    for (int col = 0; col < columns.count(); col++)
+    {
+        while (codes.count() <= columns[col].multiSelect)
+            codes.append(QStringList());
+    }
+    if (task.multiSelect_sql == "")
+        return 0;
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    if (!query.exec(task.multiSelect_sql))
+    {
+        error = query.lastError().databaseText();
+        return 1;
+    }
+    while (query.next())
+    {
+        QStringList values;
+        for (int k = 0; k < numKeys; k++)
+            values.append(query.value(k).toString());
+        QList<QStringList> &row_codes = chunkCodes[values.join("\t")];
+        if (row_codes.isEmpty())
+            row_codes = codes;
+        row_codes[query.value(numKeys).toInt()].append(query.value(numKeys + 1).toString());
+    }
+    if (query.lastError().isValid())
+    {
+        error = query.lastError().databaseText();
+        return 1;
+    }
+    return 0;
+}
+
+int rowResolver::finish()
+{
+    chunkCodes.clear();
+    return 0;
+}
+
+QStringList rowResolver::header()
+{
+    QStringList names;
+    for (int col = 0; col < columns.count(); col++)
+        names.append(columns[col].name);
+    return names;
+}
+
+QStringList rowResolver::resolve(const QSqlRecord &record)
+{
+    if (codes.count() > 0)
+    {
+        for (int msel = 0; msel < codes.count(); msel++)
+            codes[msel].clear();
+        QHash<QString, QList<QStringList> >::const_iterator row_codes = chunkCodes.constFind(getKey(record, keys));
+        if (row_codes != chunkCodes.constEnd())
+            codes = row_codes.value();
+    }
+
+    QStringList values;
+    for (int col = 0; col < columns.count(); col++)
+    {
+        const TresolveColumn &column = columns[col];
+        if (column.action == 0)
+        {
+            values.append(rowWriter::textValue(record.value(column.source)));
+            continue;
+        }
+        if (column.action == 1)
+        {
+            QString code = record.value(column.source).toString();
+            const QHash<QString, QString> &descriptions = (*lookups)[column.lookupTable + "." + column.lookupField];
+            if (descriptions.contains(code))
+                values.append(descriptions.value(code));
+            else
+            {
+                if (column.keepCode)
+                    values.append(code);
+                else
+                    values.append("");
+            }
+            continue;
+        }
+        if (column.action == 2)
+        {
+            values.append(codes[column.multiSelect].join(","));
+            continue;
+        }
+        const QHash<QString, QString> &descriptions = (*lookups)[column.lookupTable + "." + column.lookupField];
+        QStringList descs;
+        for (int pos = 0; pos < codes[column.multiSelect].count(); pos++)
+        {
+            if (descriptions.contains(codes[column.multiSelect][pos]))
+                descs.append(descriptions.value(codes[column.multiSelect][pos]));
+        }
+        values.append(descs.join(","));
+    }
+    return values;
+}
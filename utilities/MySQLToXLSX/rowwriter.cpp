@@ -0,0 +1,214 @@
+#include "rowwriter.h"
+#include <QVariant>
+#include <QDateTime>
+#include "xlsxwriter.h"
+
+rowWriter::rowWriter()
+{
+    out = nullptr;
+    workbook = nullptr;
+    sharedCache = nullptr;
+    numRows = 0;
+    numLines = 0;
+    failed = false;
+}
+
+rowWriter::~rowWriter()
+{
+    if (file.isOpen())
+        file.close();
+}
+
+int rowWriter::open(QString fileName)
+{
+    numRows = 0;
+    numLines = 0;
+    failed = false;
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return 1;
+    out = &file;
+    return 0;
+}
+
+//Writes to a device owned by someone else, like the worksheet of the workbook
+void rowWriter::open(QIODevice *device)
+{
+    numRows = 0;
+    numLines = 0;
+    failed = false;
+    out = device;
+}
+
+//The shared columns are written as indexes in the shared strings of the workbook. The cache belongs to
+//the worker and keeps the indexes it already got, so the workers do not wait on the lock of the workbook
+void rowWriter::setSharedStrings(xlsxWriter *workbook, QList<bool> shared, QHash<QString, int> *cache)
+{
+    this->workbook = workbook;
+    this->shared = shared;
+    sharedCache = cache;
+}
+
+//Codes with leading zeros and identifiers longer than Excel's precision are kept as text
+static bool isNumber(const QString &value)
+{
+    int len = value.length();
+    int pos = 0;
+    int digits = 0;
+    bool point = false;
+    if (value.at(0) == '-')
+        pos++;
+    if (pos >= len)
+        return false;
+    if ((value.at(pos) == '0') && (pos + 1 < len) && (value.at(pos + 1) != '.'))
+        return false;
+    for (; pos < len; pos++)
+    {
+        ushort c = value.at(pos).unicode();
+        if (c == '.')
+        {
+            if ((point) || (digits == 0))
+                return false;
+            point = true;
+            continue;
+        }
+        if ((c < '0') || (c > '9'))
+            return false;
+        digits++;
+    }
+    if (value.at(len - 1) == '.')
+        return false;
+    return (digits <= 15);
+}
+
+void rowWriter::writeText(const QString &value)
+{
+    if (value.isEmpty())
+    {
+        line.append("<c/>");
+        return;
+    }
+    line.append("<c t=\"inlineStr\"><is><t xml:space=\"preserve\">");
+    line.append(xlsxWriter::escape(value));
+    line.append("</t></is></c>");
+}
+
+//Every cell is written, even if empty, because the cells do not have a reference to their column
+void rowWriter::writeValue(int column, const QString &value)
+{
+    if (value.isEmpty())
+    {
+        line.append("<c/>");
+        return;
+    }
+    if ((workbook != nullptr) && (column < shared.count()) && (shared[column]))
+    {
+        int index = sharedCache->value(value, -1);
+        if (index < 0)
+        {
+            index = workbook->sharedString(value);
+            sharedCache->insert(value, index);
+        }
+        line.append("<c t=\"s\"><v>");
+        line.append(QByteArray::number(index));
+        line.append("</v></c>");
+        return;
+    }
+    if (isNumber(value))
+    {
+        line.append("<c><v>");
+        line.append(value.toLatin1());
+        line.append("</v></c>");
+        return;
+    }
+    writeText(value);
+}
+
+void rowWriter::writeLine()
+{
+    line.append("</row>\n");
+    if (out->write(line) < 0)
+        failed = true;
+    numLines++;
+}
+
+void rowWriter::writeHeader(const QSqlRecord &record)
+{
+    line = "<row>";
+    for (int col = 0; col < record.count(); col++)
+        writeText(record.fieldName(col));
+    writeLine();
+}
+
+void rowWriter::writeRow(const QSqlRecord &record)
+{
+    line = "<row>";
+    for (int col = 0; col < record.count(); col++)
+    {
+        if (record.isNull(col))
+            writeValue(col, "");
+        else
+            writeValue(col, textValue(record.value(col)));
+    }
+    writeLine();
+    numRows++;
+}
+
+void rowWriter::writeHeader(const QStringList &names)
+{
+    line = "<row>";
+    for (int col = 0; col < names.count(); col++)
+        writeText(names[col]);
+    writeLine();
+}
+
+void rowWriter::writeRow(const QStringList &values)
+{
+    line = "<row>";
+    for (int col = 0; col < values.count(); col++)
+        writeValue(col, values[col]);
+    writeLine();
+    numRows++;
+}
+
+int rowWriter::rows()
+{
+    return numRows;
+}
+
+//The values are written as MySQL writes them: the dates are not in ISO format and the decimals keep
+//their digits because the queries of the chunks read the numbers with QSql::HighPrecision
+QString rowWriter::textValue(const QVariant &value)
+{
+    switch (value.type())
+    {
+    case QVariant::DateTime:
+        return value.toDateTime().toString("yyyy-MM-dd HH:mm:ss");
+    case QVariant::Date:
+        return value.toDate().toString("yyyy-MM-dd");
+    case QVariant::Time:
+        return value.toTime().toString("HH:mm:ss");
+    default:
+        return value.toString();
+    }
+}
+
+//A sheet cannot have more than XLSX_MAX_ROWS rows. The planning splits the big tables in parts that fit
+//in their sheets, so this only happens when a whole table goes in one part
+bool rowWriter::isFull()
+{
+    return (numLines >= XLSX_MAX_ROWS);
+}
+
+//Only the file of a chunk is closed. A device given to open() stays open
+int rowWriter::close()
+{
+    if (failed)
+        return 1;
+    if (!file.isOpen())
+        return 0;
+    file.close();
+    if (file.error() != QFileDevice::NoError)
+        return 1;
+    return 0;
+}
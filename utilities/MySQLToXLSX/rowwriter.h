@@ -0,0 +1,45 @@
+#ifndef ROWWRITER_H
+#define ROWWRITER_H
+
+#include <QFile>
+#include <QSqlRecord>
+#include <QVariant>
+#include <QHash>
+
+class xlsxWriter;
+
+//Writes the rows of a query result as rows of a worksheet as they are fetched from the server.
+//The rows go to the worksheet being written or to the temporary file of a chunk. Plain numbers
+//are written as numbers, the columns marked as shared as shared strings and the rest as inline text
+class rowWriter
+{
+public:
+    rowWriter();
+    ~rowWriter();
+    int open(QString fileName);
+    void open(QIODevice *device);
+    void setSharedStrings(xlsxWriter *workbook, QList<bool> shared, QHash<QString, int> *cache);
+    void writeHeader(const QSqlRecord &record);
+    void writeRow(const QSqlRecord &record);
+    void writeHeader(const QStringList &names);
+    void writeRow(const QStringList &values);
+    int close();
+    int rows();
+    static QString textValue(const QVariant &value);
+    bool isFull();
+private:
+    void writeValue(int column, const QString &value);
+    void writeText(const QString &value);
+    void writeLine();
+    QFile file;
+    QIODevice *out;
+    xlsxWriter *workbook;
+    QList<bool> shared;
+    QHash<QString, int> *sharedCache;
+    QByteArray line;
+    int numRows;
+    int numLines;
+    bool failed;
+};
+
+#endif // ROWWRITER_H
@@ -0,0 +1,275 @@
+#include "sheetwriter.h"
+#include <QMutexLocker>
+
+deflateDevice::deflateDevice()
+{
+    initialized = false;
+    crcValue = 0;
+    total = 0;
+}
+
+deflateDevice::~deflateDevice()
+{
+    if (initialized)
+        deflateEnd(&stream);
+}
+
+bool deflateDevice::isSequential() const
+{
+    return true;
+}
+
+//Windows bits are negative so zlib writes the deflate data without its own header, as a zip expects
+bool deflateDevice::create(QString fileName)
+{
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+    initialized = true;
+    crcValue = crc32(0L, Z_NULL, 0);
+    total = 0;
+    buffer.resize(262144);
+    return QIODevice::open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
+
+bool deflateDevice::deflateData(int flush)
+{
+    int res;
+    do
+    {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+        stream.avail_out = static_cast<uInt>(buffer.size());
+        res = deflate(&stream, flush);
+        if (res == Z_STREAM_ERROR)
+            return false;
+        qint64 have = buffer.size() - stream.avail_out;
+        if (have > 0)
+        {
+            if (file.write(buffer.constData(), have) != have)
+                return false;
+        }
+    } while ((stream.avail_out == 0) && (res != Z_STREAM_END));
+    if ((flush == Z_FINISH) && (res != Z_STREAM_END))
+        return false;
+    return true;
+}
+
+qint64 deflateDevice::writeData(const char *data, qint64 maxSize)
+{
+    if (!initialized)
+        return -1;
+    crcValue = crc32(crcValue, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(maxSize));
+    total = total + maxSize;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(maxSize);
+    if (!deflateData(Z_NO_FLUSH))
+        return -1;
+    return maxSize;
+}
+
+qint64 deflateDevice::readData(char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+bool deflateDevice::finish()
+{
+    if (!initialized)
+        return false;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    bool res = deflateData(Z_FINISH);
+    deflateEnd(&stream);
+    initialized = false;
+    QIODevice::close();
+    file.close();
+    if (file.error() != QFileDevice::NoError)
+        return false;
+    return res;
+}
+
+quint32 deflateDevice::crc()
+{
+    return crcValue;
+}
+
+qint64 deflateDevice::size()
+{
+    return total;
+}
+
+sheetWriter::sheetWriter(xlsxWriter *workbook, int number, QString name)
+{
+    book = workbook;
+    sheetNumber = number;
+    sheetName = name;
+    chunks = 0;
+    window = 1;
+    next = 0;
+    started = false;
+    aborted = false;
+    complete = false;
+}
+
+//The chunks must be added in the order their rows go in the sheet
+int sheetWriter::addChunk()
+{
+    chunks++;
+    return chunks - 1;
+}
+
+void sheetWriter::setFile(QString fileName, int window)
+{
+    deflateFile = fileName;
+    this->window = window;
+    if (this->window < 1)
+        this->window = 1;
+}
+
+int sheetWriter::number()
+{
+    return sheetNumber;
+}
+
+QString sheetWriter::name()
+{
+    return sheetName;
+}
+
+QString sheetWriter::fileName()
+{
+    return deflateFile;
+}
+
+quint32 sheetWriter::crc()
+{
+    return stream.crc();
+}
+
+qint64 sheetWriter::size()
+{
+    return stream.size();
+}
+
+xlsxWriter *sheetWriter::workbook()
+{
+    return book;
+}
+
+bool sheetWriter::isComplete()
+{
+    QMutexLocker locker(&mutex);
+    return complete;
+}
+
+//The rows do not have cell references, so the chunks of a sheet can be written without knowing where they start
+int sheetWriter::start()
+{
+    if (!stream.create(deflateFile))
+        return 1;
+    stream.write("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n");
+    stream.write("<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\"><sheetData>\n");
+    started = true;
+    return 0;
+}
+
+//Waits until the chunk is inside the window. Returns 0 if the chunk is the head and must be
+//written directly to device(), 1 if it must be written to its temporary file and -1 if
+//another chunk of the sheet failed
+int sheetWriter::beginChunk(int chunk)
+{
+    QMutexLocker locker(&mutex);
+    while ((chunk >= next + window) && (!aborted))
+        advanced.wait(&mutex);
+    if (aborted)
+        return -1;
+    if (chunk != next)
+        return 1;
+    if (!started)
+    {
+        if (start() != 0)
+        {
+            aborted = true;
+            advanced.wakeAll();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+//Only the worker with the head chunk writes to the stream
+QIODevice *sheetWriter::device()
+{
+    return &stream;
+}
+
+int sheetWriter::appendFile(QString chunkFile)
+{
+    QFile chunk(chunkFile);
+    if (!chunk.open(QIODevice::ReadOnly))
+        return 1;
+    while (!chunk.atEnd())
+    {
+        if (stream.write(chunk.read(1048576)) < 0)
+            return 1;
+    }
+    chunk.close();
+    chunk.remove();
+    return 0;
+}
+
+//Called with the mutex locked once the head chunk is in the stream. The stream is finished after the last chunk
+int sheetWriter::advance()
+{
+    next++;
+    if (next < chunks)
+        return 0;
+    stream.write("</sheetData></worksheet>\n");
+    if (!stream.finish())
+        return 1;
+    complete = true;
+    return 0;
+}
+
+//Marks a chunk as finished. chunkFile is empty if the chunk was written directly.
+//The chunks waiting for it are appended in order
+int sheetWriter::endChunk(int chunk, QString chunkFile)
+{
+    QMutexLocker locker(&mutex);
+    if (aborted)
+        return 1;
+    if (chunk != next)
+    {
+        pending.insert(chunk, chunkFile);
+        return 0;
+    }
+    int res = 0;
+    if (chunkFile != "")
+        res = appendFile(chunkFile);
+    if (res == 0)
+        res = advance();
+    while ((res == 0) && (pending.contains(next)))
+    {
+        res = appendFile(pending.take(next));
+        if (res == 0)
+            res = advance();
+    }
+    if (res != 0)
+        aborted = true;
+    advanced.wakeAll();
+    return res;
+}
+
+void sheetWriter::abort()
+{
+    QMutexLocker locker(&mutex);
+    aborted = true;
+    advanced.wakeAll();
+}
@@ -0,0 +1,81 @@
+#ifndef SHEETWRITER_H
+#define SHEETWRITER_H
+
+#include <QString>
+#include <QFile>
+#include <QIODevice>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+#include <zlib.h>
+
+class xlsxWriter;
+
+//Compresses what is written to it as a raw deflate stream, the format of the entries of a zip,
+//and keeps the CRC and the size that the zip needs for the entry
+class deflateDevice : public QIODevice
+{
+public:
+    deflateDevice();
+    ~deflateDevice();
+    bool create(QString fileName);
+    bool finish();
+    bool isSequential() const override;
+    quint32 crc();
+    qint64 size();
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+private:
+    bool deflateData(int flush);
+    QFile file;
+    z_stream stream;
+    bool initialized;
+    quint32 crcValue;
+    qint64 total;
+    QByteArray buffer;
+};
+
+//Writes one worksheet compressed in a temporary file, so the sheets of the workbook are built and compressed
+//at the same time by different workers. The chunks of the sheet are written in order: the chunk at the head
+//goes directly into the compressed stream, the ones that finish before their turn are kept in their temporary
+//files and appended as soon as the ones before them are written. A worker cannot start a chunk more than
+//"window" chunks ahead of the head. xlsxWriter copies the compressed sheets into the XLSX file at the end
+class sheetWriter
+{
+public:
+    sheetWriter(xlsxWriter *workbook, int number, QString name);
+    int addChunk();
+    void setFile(QString fileName, int window);
+    int beginChunk(int chunk);
+    QIODevice *device();
+    int endChunk(int chunk, QString chunkFile);
+    void abort();
+    bool isComplete();
+    int number();
+    QString name();
+    QString fileName();
+    quint32 crc();
+    qint64 size();
+    xlsxWriter *workbook();
+private:
+    int start();
+    int appendFile(QString chunkFile);
+    int advance();
+    xlsxWriter *book;
+    deflateDevice stream;
+    int sheetNumber;
+    QString sheetName;
+    QString deflateFile;
+    int chunks;
+    int window;
+    int next;
+    bool started;
+    bool aborted;
+    bool complete;
+    QMap<int, QString> pending;
+    QMutex mutex;
+    QWaitCondition advanced;
+};
+
+#endif // SHEETWRITER_H
@@ -0,0 +1,244 @@
+#include "xlsxwriter.h"
+#include <QFile>
+#include <QMutexLocker>
+#include <QDir>
+
+xlsxWriter::xlsxWriter()
+{
+
+}
+
+xlsxWriter::~xlsxWriter()
+{
+    if (entry.isOpen())
+        entry.close();
+    if (zip.isOpen())
+        zip.close();
+    qDeleteAll(sheets);
+}
+
+int xlsxWriter::addSheet(QString name)
+{
+    sheets.append(new sheetWriter(this, sheets.count() + 1, name));
+    return sheets.count() - 1;
+}
+
+sheetWriter *xlsxWriter::sheet(int index)
+{
+    return sheets[index];
+}
+
+QString xlsxWriter::fileName()
+{
+    return finalFile;
+}
+
+//Escapes a value for the XML of the workbook. The characters not allowed in XML are removed and the
+//value is cut to the 32767 characters a cell can hold
+QByteArray xlsxWriter::escape(const QString &value)
+{
+    QString res;
+    int len = value.length();
+    if (len > 32767)
+        len = 32767;
+    res.reserve(len + 16);
+    for (int pos = 0; pos < len; pos++)
+    {
+        ushort c = value.at(pos).unicode();
+        if (c == '&')
+            res.append("&amp;");
+        else if (c == '<')
+            res.append("&lt;");
+        else if (c == '>')
+            res.append("&gt;");
+        else if ((c < 0x20) && (c != 0x09) && (c != 0x0A) && (c != 0x0D))
+            continue;
+        else if ((c == 0xFFFE) || (c == 0xFFFF))
+            continue;
+        else if (QChar::isHighSurrogate(c))
+        {
+            if ((pos + 1 < value.length()) && (QChar::isLowSurrogate(value.at(pos + 1).unicode())))
+            {
+                res.append(value.at(pos));
+                res.append(value.at(pos + 1));
+                pos++;
+            }
+        }
+        else if (QChar::isLowSurrogate(c))
+            continue;
+        else
+            res.append(value.at(pos));
+    }
+    return res.toUtf8();
+}
+
+int xlsxWriter::writeEntry(QString name, QByteArray data)
+{
+    if (!entry.open(QIODevice::WriteOnly, QuaZipNewInfo(name)))
+        return 1;
+    entry.write(data);
+    entry.close();
+    if (entry.getZipError() != UNZ_OK)
+        return 1;
+    return 0;
+}
+
+//Creates the XLSX file with the parts that only depend on the sheets. The sheets are compressed in the temporary directory
+int xlsxWriter::create(QString fileName, QString tempDir, int window)
+{
+    finalFile = fileName;
+    QDir dir(tempDir);
+    for (int pos = 0; pos < sheets.count(); pos++)
+        sheets[pos]->setFile(dir.absolutePath() + dir.separator() + "sheet" + QString::number(pos + 1) + ".deflate", window);
+
+    zip.setZipName(finalFile);
+    //Big sheets and workbooks pass the 4 GB of the classic zip headers
+    zip.setZip64Enabled(true);
+    if (!zip.open(QuaZip::mdCreate))
+        return 1;
+    entry.setZip(&zip);
+
+    QByteArray header = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+    QByteArray types = header + "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">";
+    types.append("<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>");
+    types.append("<Default Extension=\"xml\" ContentType=\"application/xml\"/>");
+    types.append("<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>");
+    QByteArray workbook = header + "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\"><sheets>";
+    QByteArray relations = header + "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">";
+    for (int pos = 0; pos < sheets.count(); pos++)
+    {
+        QByteArray number = QByteArray::number(pos + 1);
+        types.append("<Override PartName=\"/xl/worksheets/sheet" + number + ".xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>");
+        workbook.append("<sheet name=\"" + escape(sheets[pos]->name()).replace("\"","&quot;") + "\" sheetId=\"" + number + "\" r:id=\"rId" + number + "\"/>");
+        relations.append("<Relationship Id=\"rId" + number + "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet" + number + ".xml\"/>");
+    }
+    types.append("<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>");
+    types.append("<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>");
+    types.append("</Types>");
+    workbook.append("</sheets></workbook>");
+    relations.append("<Relationship Id=\"rId" + QByteArray::number(sheets.count() + 1) + "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>");
+    relations.append("<Relationship Id=\"rId" + QByteArray::number(sheets.count() + 2) + "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"sharedStrings.xml\"/>");
+    relations.append("</Relationships>");
+
+    QByteArray rels = header + "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">";
+    rels.append("<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>");
+    rels.append("</Relationships>");
+
+    QByteArray styles = header + "<styleSheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">";
+    styles.append("<fonts count=\"1\"><font><sz val=\"11\"/><name val=\"Calibri\"/></font></fonts>");
+    styles.append("<fills count=\"2\"><fill><patternFill patternType=\"none\"/></fill><fill><patternFill patternType=\"gray125\"/></fill></fills>");
+    styles.append("<borders count=\"1\"><border><left/><right/><top/><bottom/><diagonal/></border></borders>");
+    styles.append("<cellStyleXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/></cellStyleXfs>");
+    styles.append("<cellXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\"/></cellXfs>");
+    styles.append("<cellStyles count=\"1\"><cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/></cellStyles>");
+    styles.append("</styleSheet>");
+
+    if (writeEntry("[Content_Types].xml", types) != 0)
+        return 1;
+    if (writeEntry("_rels/.rels", rels) != 0)
+        return 1;
+    if (writeEntry("xl/workbook.xml", workbook) != 0)
+        return 1;
+    if (writeEntry("xl/_rels/workbook.xml.rels", relations) != 0)
+        return 1;
+    if (writeEntry("xl/styles.xml", styles) != 0)
+        return 1;
+    return 0;
+}
+
+//The sheet is already compressed so it is stored raw with the CRC and size of its XML
+int xlsxWriter::copySheet(sheetWriter *sheet)
+{
+    QuaZipNewInfo info("xl/worksheets/sheet" + QString::number(sheet->number()) + ".xml");
+    info.uncompressedSize = sheet->size();
+    if (!entry.open(QIODevice::WriteOnly, info, nullptr, sheet->crc(), Z_DEFLATED, Z_DEFAULT_COMPRESSION, true))
+        return 1;
+    QFile file(sheet->fileName());
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        entry.close();
+        return 1;
+    }
+    while (!file.atEnd())
+    {
+        if (entry.write(file.read(1048576)) < 0)
+        {
+            entry.close();
+            return 1;
+        }
+    }
+    file.close();
+    file.remove();
+    entry.close();
+    if (entry.getZipError() != UNZ_OK)
+        return 1;
+    return 0;
+}
+
+//Returns the index of a value in the shared strings of the workbook. The workers call it through their
+//own cache so the lock is taken once per distinct value and worker and not once per cell
+int xlsxWriter::sharedString(const QString &value)
+{
+    QMutexLocker locker(&stringsMutex);
+    int index = stringIndex.value(value, -1);
+    if (index < 0)
+    {
+        index = strings.count();
+        strings.append(value);
+        stringIndex.insert(value, index);
+    }
+    return index;
+}
+
+//Adds the sheets and the shared strings and closes the file. The file is removed if any sheet is incomplete
+int xlsxWriter::close()
+{
+    bool complete = zip.isOpen();
+    for (int pos = 0; pos < sheets.count(); pos++)
+    {
+        if (!sheets[pos]->isComplete())
+            complete = false;
+    }
+    for (int pos = 0; pos < sheets.count(); pos++)
+    {
+        if ((complete) && (copySheet(sheets[pos]) != 0))
+            complete = false;
+        QFile::remove(sheets[pos]->fileName());
+    }
+    if (complete)
+    {
+        complete = false;
+        if (entry.open(QIODevice::WriteOnly, QuaZipNewInfo("xl/sharedStrings.xml")))
+        {
+            QByteArray data = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+            data.append("<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" uniqueCount=\"" + QByteArray::number(strings.count()) + "\">");
+            for (int pos = 0; pos < strings.count(); pos++)
+            {
+                data.append("<si><t xml:space=\"preserve\">" + escape(strings[pos]) + "</t></si>");
+                if (data.size() >= 1048576)
+                {
+                    entry.write(data);
+                    data.clear();
+                }
+            }
+            data.append("</sst>");
+            entry.write(data);
+            entry.close();
+            complete = (entry.getZipError() == UNZ_OK);
+        }
+    }
+    if (entry.isOpen())
+        entry.close();
+    if (zip.isOpen())
+    {
+        zip.close();
+        if (zip.getZipError() != UNZ_OK)
+            complete = false;
+    }
+    if (!complete)
+    {
+        QFile::remove(finalFile);
+        return 1;
+    }
+    return 0;
+}
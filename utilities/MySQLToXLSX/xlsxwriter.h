@@ -0,0 +1,44 @@
+#ifndef XLSXWRITER_H
+#define XLSXWRITER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QuaZip-Qt5-1.3/quazip/quazip.h>
+#include <QuaZip-Qt5-1.3/quazip/quazipfile.h>
+#include "sheetwriter.h"
+
+//Rows of a worksheet counting the header. A table with more rows continues in other sheets
+#define XLSX_MAX_ROWS 1048576
+
+//Writes the XLSX file. Each sheet is built and compressed on its own by sheetWriter, so the workers
+//write several sheets at the same time. When all of them are done the compressed sheets are copied
+//as they are into the zip, which writes the central directory. The lookup descriptions go to the
+//shared strings of the workbook
+class xlsxWriter
+{
+public:
+    xlsxWriter();
+    ~xlsxWriter();
+    int addSheet(QString name);
+    sheetWriter *sheet(int index);
+    int create(QString fileName, QString tempDir, int window);
+    int sharedString(const QString &value);
+    int close();
+    QString fileName();
+    static QByteArray escape(const QString &value);
+private:
+    int writeEntry(QString name, QByteArray data);
+    int copySheet(sheetWriter *sheet);
+    QuaZip zip;
+    QuaZipFile entry;
+    QString finalFile;
+    QList<sheetWriter*> sheets;
+    QHash<QString, int> stringIndex;
+    QStringList strings;
+    QMutex stringsMutex;
+};
+
+#endif // XLSXWRITER_H
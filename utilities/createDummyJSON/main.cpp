@@ -32,6 +32,8 @@ namespace pt = boost::property_tree;
 
 bool keysForRepo;
 int resolve_type;
+bool typedValues;
+QString seed;
 
 struct arraySizeItem
 {
@@ -84,7 +86,7 @@ QStringList getLookUpValues(QString table)
     return result;
 }
 
-QStringList separateMultiSelect(QString multiSelectTable, QString variableName)
+QStringList getMultiSelectCodes(QString multiSelectTable)
 {
     QStringList result;
     QDomElement rootCreate = xmlCreateDocument.documentElement();
@@ -113,6 +115,12 @@ QStringList separateMultiSelect(QString multiSelectTable, QString variableName)
             fieldNode = fieldNode.nextSibling();
         }
     }
+    return result;
+}
+
+QStringList separateMultiSelect(QString multiSelectTable, QString variableName)
+{
+    QStringList result = getMultiSelectCodes(multiSelectTable);
 
     for (int pos = 0; pos < result.count(); pos++)
     {
@@ -122,6 +130,54 @@ QStringList separateMultiSelect(QString multiSelectTable, QString variableName)
     return result;
 }
 
+//Returns a value of the type of the field so the submission can be imported.
+//Key fields get the seed so each generated submission is unique.
+QString typedValue(QDomElement field)
+{
+    QString type = field.attribute("type","varchar");
+    int size = field.attribute("size","0").toInt();
+    QString value;
+    if (!typedValues)
+        return "dummy";
+    if ((field.attribute("isMultiSelect","false") == "true") && (field.attribute("multiSelectTable") != ""))
+    {
+        QStringList codes = getMultiSelectCodes(field.attribute("multiSelectTable"));
+        if (codes.count() > 0)
+            return codes[0];
+        return "dummy";
+    }
+    if (field.attribute("rlookup","false") == "true")
+    {
+        QStringList codes = getLookUpValues(field.attribute("rtable"));
+        if (codes.count() > 0)
+            return codes[0];
+        return "dummy";
+    }
+    if (field.attribute("key","false") == "true")
+    {
+        if (type == "int")
+            return seed;
+        value = "k" + seed;
+    }
+    else
+    {
+        if (type == "int")
+            return "1";
+        if (type == "decimal")
+            return "1";
+        if (type == "date")
+            return "2020-01-01";
+        if (type == "datetime")
+            return "2020-01-01 10:00:00";
+        if (type == "time")
+            return "10:00:00";
+        value = "dummy";
+    }
+    if ((type == "varchar") && (size > 0))
+        value = value.right(size);
+    return value;
+}
+
 void parseCreateFile(QDomNode node, pt::ptree &json)
 {
     while (!node.isNull())
@@ -144,16 +200,16 @@ void parseCreateFile(QDomNode node, pt::ptree &json)
                 if ((node.toElement().attribute("isMultiSelect","false") == "true") && (node.toElement().attribute("multiSelectTable") != ""))
                 {
                     if (resolve_type == 1 || resolve_type == 2)
-                        json.put(xmlCode.toStdString(),"dummy");
+                        json.put(xmlCode.toStdString(),typedValue(node.toElement()).toStdString());
                     else
                     {
                         if (keysForRepo)
                         {
-                            json.put(xmlCode.toStdString(),"dummy");
+                            json.put(xmlCode.toStdString(),typedValue(node.toElement()).toStdString());
                             json.put(xmlCode.toStdString() + "-desc","dummy");
                         }
                         else
-                            json.put(xmlCode.toStdString(),"dummy");
+                            json.put(xmlCode.toStdString(),typedValue(node.toElement()).toStdString());
                     }
                 }
                 else
@@ -161,20 +217,20 @@ void parseCreateFile(QDomNode node, pt::ptree &json)
                     if (node.toElement().attribute("rlookup","false") == "true")
                     {
                         if (resolve_type == 1 || resolve_type == 2)
-                            json.put(xmlCode.toStdString(),"dummy");
+                            json.put(xmlCode.toStdString(),typedValue(node.toElement()).toStdString());
                         else
                         {
                             if (keysForRepo)
                             {
-                                json.put(xmlCode.toStdString(),"dummy");
+                                json.put(xmlCode.toStdString(),typedValue(node.toElement()).toStdString());
                                 json.put(xmlCode.toStdString() + "-desc","dummy");
                             }
                             else
-                                json.put(xmlCode.toStdString(),"dummy");
+                                json.put(xmlCode.toStdString(),typedValue(node.toElement()).toStdString());
                         }
                     }
                     else
-                        json.put(xmlCode.toStdString(),"dummy");
+                        json.put(xmlCode.toStdString(),typedValue(node.toElement()).toStdString());
                 }
             }
         }
@@ -219,11 +275,16 @@ int main(int argc, char *argv[])
     TCLAP::ValueArg<std::string> arraysArg("a","arrays","Array sizes as defined as name:size,name:size",false,"","string");
     TCLAP::ValueArg<std::string> resolveArg("l","resolve","Resolve lookup values: 1=Codes only (default), 2=Descriptions, 3=Codes and descriptions",false,"1","string");
     TCLAP::SwitchArg repoSwitch("r","repository","Generate keys for repository", cmd, false);    
+    TCLAP::ValueArg<std::string> insertArg("i","insert","Input insert XML file. Used to get the lookup codes with -v",false,"","string");
+    TCLAP::SwitchArg typedSwitch("v","values","Generate values of the type of each field so the file can be imported", cmd, false);
+    TCLAP::ValueArg<std::string> seedArg("k","keyseed","Number used as the value of the key fields with -v. Default 1",false,"1","string");
 
     cmd.add(createArg);    
     cmd.add(outputArg);
     cmd.add(arraysArg);
     cmd.add(resolveArg);
+    cmd.add(insertArg);
+    cmd.add(seedArg);
 
     //Parsing the command lines
     cmd.parse( argc, argv );
@@ -237,6 +298,25 @@ int main(int argc, char *argv[])
     QString tresolve_type = QString::fromUtf8(resolveArg.getValue().c_str());
     resolve_type = tresolve_type.toInt();
     keysForRepo = repoSwitch.getValue();    
+    typedValues = typedSwitch.getValue();
+    seed = QString::fromUtf8(seedArg.getValue().c_str());
+    QString xmlInsert = QString::fromUtf8(insertArg.getValue().c_str());
+    if (xmlInsert != "")
+    {
+        QFile fileInsert(xmlInsert);
+        if (!fileInsert.open(QIODevice::ReadOnly))
+        {
+            log("Cannot open insert xml file");
+            return 1;
+        }
+        if (!xmlInsertDocument.setContent(&fileInsert))
+        {
+            log("Cannot parse insert xml file");
+            fileInsert.close();
+            return 1;
+        }
+        fileInsert.close();
+    }
 
     if (sarrays != "")
     {
@@ -283,8 +363,16 @@ int main(int argc, char *argv[])
                 if (!keysForRepo)
                 {
                     JSONRoot.put("_xform_id_string","dummy");
-                    JSONRoot.put("_submission_id","dummy");
-                    JSONRoot.put("meta/instanceID","dummy");
+                    if (typedValues)
+                    {
+                        JSONRoot.put("_submission_id",seed.toStdString());
+                        JSONRoot.put("meta/instanceID",QString("uuid:dummy-" + seed).toStdString());
+                    }
+                    else
+                    {
+                        JSONRoot.put("_submission_id","dummy");
+                        JSONRoot.put("meta/instanceID","dummy");
+                    }
                     JSONRoot.put("_project_code","dummy");
                     JSONRoot.put("_user_id","dummy");
                 }